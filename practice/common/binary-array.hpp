@@ -0,0 +1,324 @@
+#pragma once
+
+#include "fast-io.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Двоичный формат массива: заголовок и сразу за ним элементы в том виде, в
+// каком они лежат в памяти. Такой файл не нужно разбирать -- его можно
+// отобразить в память через mmap и отсортировать прямо на месте через
+// std::span, без копии в куче. Результатом сортировки является сам файл,
+// поэтому его сразу может читать следующий этап обработки.
+
+// Тип элементов массива.
+enum class ElementType : uint32_t {
+    I8 = 1,
+    U8,
+    I16,
+    U16,
+    I32,
+    U32,
+    I64,
+    U64,
+    F32,
+    F64,
+};
+
+// Какому ElementType соответствует тип T.
+template<class T>
+constexpr ElementType elementTypeOf() {
+    if constexpr (std::is_same_v<T, int8_t>) return ElementType::I8;
+    else if constexpr (std::is_same_v<T, uint8_t>) return ElementType::U8;
+    else if constexpr (std::is_same_v<T, int16_t>) return ElementType::I16;
+    else if constexpr (std::is_same_v<T, uint16_t>) return ElementType::U16;
+    else if constexpr (std::is_same_v<T, int32_t>) return ElementType::I32;
+    else if constexpr (std::is_same_v<T, uint32_t>) return ElementType::U32;
+    else if constexpr (std::is_same_v<T, int64_t>) return ElementType::I64;
+    else if constexpr (std::is_same_v<T, uint64_t>) return ElementType::U64;
+    else if constexpr (std::is_same_v<T, float>) return ElementType::F32;
+    else if constexpr (std::is_same_v<T, double>) return ElementType::F64;
+    else static_assert(!sizeof(T), "unsupported element type");
+}
+
+// Тип по короткому имени, которое используют флаги --type наших программ
+// (i32, u64, f64 и т.д.).
+inline ElementType elementTypeFromName(const std::string& name) {
+    const char* names[] = {"i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32", "f64"};
+    for (uint32_t i = 0; i < std::size(names); i++) {
+        if (name == names[i]) {
+            return static_cast<ElementType>(i + 1);
+        }
+    }
+    throw std::invalid_argument("unknown element type: " + name);
+}
+
+// Заголовок файла. Он занимает 32 байта, поэтому элементы после него
+// выровнены по 8 байт и к ним можно обращаться напрямую.
+struct BinaryArrayHeader {
+    char magic[8];
+    ElementType type;
+    uint32_t elementSize;
+    uint64_t count;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(BinaryArrayHeader) == 32);
+
+constexpr char BINARY_ARRAY_MAGIC[8] = {'S', 'G', 'S', 'O', 'R', 'T', '0', '1'};
+
+// Вызываем f(std::span<T>) для типа T, соответствующего type.
+template<class F>
+void visitElementType(ElementType type, void* data, size_t count, F&& f) {
+    switch (type) {
+        case ElementType::I8: f(std::span<int8_t>(static_cast<int8_t*>(data), count)); break;
+        case ElementType::U8: f(std::span<uint8_t>(static_cast<uint8_t*>(data), count)); break;
+        case ElementType::I16: f(std::span<int16_t>(static_cast<int16_t*>(data), count)); break;
+        case ElementType::U16: f(std::span<uint16_t>(static_cast<uint16_t*>(data), count)); break;
+        case ElementType::I32: f(std::span<int32_t>(static_cast<int32_t*>(data), count)); break;
+        case ElementType::U32: f(std::span<uint32_t>(static_cast<uint32_t*>(data), count)); break;
+        case ElementType::I64: f(std::span<int64_t>(static_cast<int64_t*>(data), count)); break;
+        case ElementType::U64: f(std::span<uint64_t>(static_cast<uint64_t*>(data), count)); break;
+        case ElementType::F32: f(std::span<float>(static_cast<float*>(data), count)); break;
+        case ElementType::F64: f(std::span<double>(static_cast<double*>(data), count)); break;
+        default: throw std::runtime_error("unknown element type in binary array");
+    }
+}
+
+// Является ли type одним из значений ElementType (в заголовке файла может
+// оказаться что угодно).
+inline bool isKnownElementType(ElementType type) {
+    return type >= ElementType::I8 && type <= ElementType::F64;
+}
+
+// Размер элемента типа type в байтах.
+inline size_t elementSizeOf(ElementType type) {
+    size_t size = 0;
+    visitElementType(type, nullptr, 0, [&size](auto arr) { size = sizeof(typename decltype(arr)::value_type); });
+    return size;
+}
+
+// Двоичный массив, отображённый в память. Изменения элементов попадают прямо
+// в файл (MAP_SHARED), копии в куче нет. Файл, который нужно только прочитать
+// (например, чтобы вывести его текстом), открывается в режиме ReadOnly -- тогда
+// он может быть и недоступен на запись.
+class MappedArray {
+public:
+    enum class Mode {
+        ReadWrite,
+        ReadOnly,
+    };
+
+    explicit MappedArray(const std::string& path, Mode mode = Mode::ReadWrite)
+        : writable_(mode == Mode::ReadWrite) {
+        fd_ = ::open(path.c_str(), writable_ ? O_RDWR : O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+        }
+
+        struct stat info;
+        if (fstat(fd_, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(BinaryArrayHeader)) {
+            ::close(fd_);
+            throw std::runtime_error(path + " is not a binary array: file is too small");
+        }
+        size_ = info.st_size;
+
+        void* mapped = mmap(nullptr, size_, writable_ ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("cannot mmap " + path + ": " + std::strerror(errno));
+        }
+        mapped_ = mapped;
+
+        // Тип проверяем до elementSizeOf: на неизвестном типе она бросает
+        // исключение, а деструктор недостроенного объекта не вызывается.
+        const BinaryArrayHeader& header = this->header();
+        if (std::memcmp(header.magic, BINARY_ARRAY_MAGIC, sizeof(header.magic)) != 0 ||
+            !isKnownElementType(header.type) ||
+            header.elementSize != elementSizeOf(header.type) ||
+            header.count > (size_ - sizeof(BinaryArrayHeader)) / header.elementSize) {
+            release();
+            throw std::runtime_error(path + " is not a binary array: bad header");
+        }
+    }
+
+    ~MappedArray() {
+        release();
+    }
+
+    MappedArray(const MappedArray&) = delete;
+    MappedArray& operator=(const MappedArray&) = delete;
+
+    ElementType type() const {
+        return header().type;
+    }
+
+    size_t size() const {
+        return header().count;
+    }
+
+    // Элементы массива, если их тип -- T.
+    template<class T>
+    std::span<T> as() {
+        if (type() != elementTypeOf<T>()) {
+            throw std::runtime_error("binary array has a different element type");
+        }
+        return std::span<T>(static_cast<T*>(mutableData()), size());
+    }
+
+    // Вызываем f(std::span<T>) с элементами массива, где T -- тип из заголовка.
+    template<class F>
+    void visit(F&& f) {
+        visitElementType(type(), mutableData(), size(), f);
+    }
+
+    // То же только для чтения: f вызывается со std::span<const T>.
+    template<class F>
+    void visit(F&& f) const {
+        visitElementType(type(), const_cast<void*>(data()), size(), [&f](auto arr) {
+            f(std::span<const typename decltype(arr)::value_type>(arr));
+        });
+    }
+
+private:
+    const BinaryArrayHeader& header() const {
+        return *static_cast<const BinaryArrayHeader*>(mapped_);
+    }
+
+    const void* data() const {
+        return static_cast<const char*>(mapped_) + sizeof(BinaryArrayHeader);
+    }
+
+    void* mutableData() {
+        if (!writable_) {
+            throw std::runtime_error("binary array is opened read-only");
+        }
+        return static_cast<char*>(mapped_) + sizeof(BinaryArrayHeader);
+    }
+
+    void release() {
+        if (mapped_ != nullptr) {
+            munmap(mapped_, size_);
+            mapped_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool writable_;
+    int fd_ = -1;
+    void* mapped_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Записываем bytes байт из data в файл fd, начиная с позиции offset.
+inline void pwriteFully(int fd, const void* data, size_t bytes, off_t offset) {
+    const char* pos = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t written = ::pwrite(fd, pos, bytes, offset);
+        if (written <= 0) {
+            throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+        }
+        pos += written;
+        bytes -= written;
+        offset += written;
+    }
+}
+
+// Читаем bytes байт из файла fd, начиная с позиции offset.
+inline void preadFully(int fd, void* data, size_t bytes, off_t offset) {
+    char* pos = static_cast<char*>(data);
+    while (bytes > 0) {
+        ssize_t got = ::pread(fd, pos, bytes, offset);
+        if (got <= 0) {
+            throw std::runtime_error(std::string("read failed: ") +
+                                     (got == 0 ? "unexpected end of file" : std::strerror(errno)));
+        }
+        pos += got;
+        bytes -= got;
+        offset += got;
+    }
+}
+
+// Заголовок двоичного массива из count элементов типа T.
+template<class T>
+BinaryArrayHeader makeBinaryArrayHeader(uint64_t count) {
+    BinaryArrayHeader header{};
+    std::memcpy(header.magic, BINARY_ARRAY_MAGIC, sizeof(header.magic));
+    header.type = elementTypeOf<T>();
+    header.elementSize = sizeof(T);
+    header.count = count;
+    return header;
+}
+
+// Читаем и проверяем заголовок двоичного массива из открытого файла.
+inline BinaryArrayHeader readBinaryArrayHeader(int fd) {
+    BinaryArrayHeader header;
+    preadFully(fd, &header, sizeof(header), 0);
+    if (std::memcmp(header.magic, BINARY_ARRAY_MAGIC, sizeof(header.magic)) != 0 ||
+        !isKnownElementType(header.type) || header.elementSize != elementSizeOf(header.type)) {
+        throw std::runtime_error("not a binary array: bad header");
+    }
+    return header;
+}
+
+// Записываем массив в двоичный файл.
+template<class T>
+void writeBinaryArray(const std::string& path, std::span<const T> arr) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("cannot create " + path + ": " + std::strerror(errno));
+    }
+
+    try {
+        BinaryArrayHeader header = makeBinaryArrayHeader<T>(arr.size());
+        pwriteFully(fd, &header, sizeof(header), 0);
+        pwriteFully(fd, arr.data(), arr.size_bytes(), sizeof(header));
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+// Общая для всех сортировок обработка флага --binary: сортируем файл path
+// на месте функцией sort, которая вызывается со std::span<T> элементов файла
+// (если тип не поддерживается, она бросает исключение). Ни разбора, ни вывода
+// здесь нет, поэтому замеряется только сама сортировка.
+// Возвращает код завершения программы.
+template<class F>
+int sortBinaryFile(const std::string& path, bool benchmark_mode, bool timings_mode, F&& sort) {
+    PhaseTimings timings;
+
+    try {
+        MappedArray file(path);
+        timings.sort = measureMicroseconds([&]() { file.visit(sort); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (benchmark_mode) {
+        std::cout << timings.sort << std::endl;
+    }
+    if (timings_mode) {
+        timings.report();
+    }
+    return 0;
+}
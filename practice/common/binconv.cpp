@@ -0,0 +1,58 @@
+#include "binary-array.hpp"
+#include "fast-io.hpp"
+
+#include <exception>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+// Преобразование массивов между текстовым форматом наших программ
+// (количество элементов, затем сами элементы) и двоичным форматом,
+// который сортировки умеют сортировать на месте по флагу --binary.
+//
+//   ./a.out --to-binary FILE [--type T] < text.txt  -- текст из stdin в двоичный FILE
+//   ./a.out --to-text FILE                           -- двоичный FILE в текст на stdout
+int main(int argc, char* argv[]) {
+    std::string to_binary;
+    std::string to_text;
+
+    // тип элементов двоичного файла, по умолчанию это int
+    std::string type = "i32";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--to-binary" && i + 1 < argc) {
+            to_binary = argv[++i];
+        } else if (arg == "--to-text" && i + 1 < argc) {
+            to_text = argv[++i];
+        } else if (arg == "--type" && i + 1 < argc) {
+            type = argv[++i];
+        }
+    }
+
+    try {
+        if (!to_binary.empty()) {
+            FastInput input;
+            visitElementType(elementTypeFromName(type), nullptr, 0, [&](auto tag) {
+                using T = typename decltype(tag)::value_type;
+                auto arr = input.template readArray<T>();
+                writeBinaryArray(to_binary, std::span<const T>(arr));
+            });
+        } else if (!to_text.empty()) {
+            const MappedArray file(to_text, MappedArray::Mode::ReadOnly);
+            FastOutput output;
+            file.visit([&](auto arr) {
+                output.write(arr.size());
+                output.write('\n');
+                output.writeArray(std::span<const typename decltype(arr)::value_type>(arr));
+            });
+        } else {
+            std::cerr << "Укажите --to-binary FILE или --to-text FILE" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
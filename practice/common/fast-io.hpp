@@ -0,0 +1,374 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Общий слой ввода-вывода для всех сортировок. На десятках миллионов чисел
+// std::cin >> num и std::cout << num работают дольше самой сортировки: каждое
+// число проходит через локали, потоковые флаги и виртуальные вызовы. Здесь же
+// весь ввод сразу оказывается в памяти, числа разбираются вручную, а вывод
+// копится в большом буфере и уходит в ОС редкими системными вызовами.
+
+// Весь стандартный ввод целиком.
+class FastInput {
+public:
+    // Если stdin -- обычный файл (./a.out < data.txt), он отображается в память
+    // через mmap: никакого копирования, страницы подгружает ОС. Если же это канал
+    // (echo ... | ./a.out), читаем его большими блоками.
+    FastInput() {
+        struct stat info;
+        if (fstat(STDIN_FILENO, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+            if (mapped != MAP_FAILED) {
+                madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+                mapped_ = mapped;
+                mappedSize_ = info.st_size;
+                pos_ = static_cast<const char*>(mapped);
+                end_ = pos_ + mappedSize_;
+                return;
+            }
+        }
+
+        constexpr size_t blockSize = size_t{1} << 20;
+        size_t size = 0;
+        while (true) {
+            buffer_.resize(size + blockSize);
+            ssize_t got = ::read(STDIN_FILENO, buffer_.data() + size, blockSize);
+            if (got <= 0) {
+                break;
+            }
+            size += got;
+        }
+        buffer_.resize(size);
+        pos_ = buffer_.data();
+        end_ = pos_ + size;
+    }
+
+    ~FastInput() {
+        if (mapped_ != nullptr) {
+            munmap(mapped_, mappedSize_);
+        }
+    }
+
+    FastInput(const FastInput&) = delete;
+    FastInput& operator=(const FastInput&) = delete;
+
+    // Считываем следующее число. Возвращает false, если чисел больше нет или
+    // очередное слово -- не число либо не помещается в T (тогда позиция ввода
+    // не сдвигается, и это можно отличить по atEnd()).
+    template<class T>
+    requires std::integral<T> || std::floating_point<T>
+    bool read(T& value) {
+        if (atEnd()) {
+            return false;
+        }
+
+        if constexpr (std::floating_point<T>) {
+            // Числа с плавающей точкой разбирать вручную корректно (с правильным
+            // округлением) сложно, from_chars делает это без локалей и аллокаций.
+            auto [next, error] = std::from_chars(pos_, end_, value);
+            if (error != std::errc() || !isTokenEnd(next)) {
+                return false;
+            }
+            pos_ = next;
+            return true;
+        } else {
+            const char* start = pos_;
+            bool negative = false;
+            if (*pos_ == '-' || *pos_ == '+') {
+                negative = *pos_ == '-';
+                pos_++;
+            }
+
+            // Копим модуль числа в беззнаковом 64-битном числе и следим, чтобы
+            // он не переполнился: "3000000000" не должно молча стать int'ом
+            // -1294967296, как и "300" -- байтом 44.
+            uint64_t result = 0;
+            bool overflow = false;
+            constexpr uint64_t maxResult = std::numeric_limits<uint64_t>::max();
+
+            // Восемь цифр подряд разбираем за раз (SWAR): читаем их одним 64-битным
+            // словом и складываем попарно умножениями, без цикла по цифрам.
+            if constexpr (std::endian::native == std::endian::little) {
+                uint64_t chunk;
+                while (end_ - pos_ >= 8 && isEightDigits(chunk = load8(pos_))) {
+                    uint64_t digits = parseEightDigits(chunk);
+                    overflow |= result > (maxResult - digits) / 100000000;
+                    result = result * 100000000 + digits;
+                    pos_ += 8;
+                }
+            }
+
+            while (pos_ < end_ && static_cast<unsigned>(*pos_ - '0') < 10) {
+                unsigned digit = static_cast<unsigned>(*pos_ - '0');
+                overflow |= result > (maxResult - digit) / 10;
+                result = result * 10 + digit;
+                pos_++;
+            }
+
+            // Ни одной цифры или число вплотную переходит в другие символы ("12abc").
+            if (pos_ == start + (*start == '-' || *start == '+') || !isTokenEnd(pos_)) {
+                pos_ = start;
+                return false;
+            }
+
+            // Число не помещается в T: для отрицательных допустим модуль на
+            // единицу больше максимума (-128 для int8_t), а беззнаковым
+            // минус не положен вовсе.
+            uint64_t limit = static_cast<uint64_t>(std::numeric_limits<T>::max());
+            if (negative) {
+                limit = std::is_signed_v<T> ? limit + 1 : 0;
+            }
+            if (overflow || result > limit || (negative && std::is_unsigned_v<T>)) {
+                pos_ = start;
+                return false;
+            }
+
+            if (negative) {
+                result = 0 - result;
+            }
+            value = static_cast<T>(result);
+            return true;
+        }
+    }
+
+    // Считываем следующее слово (последовательность символов без пробелов).
+    // Слово ссылается прямо на буфер ввода и живёт, пока жив FastInput.
+    bool read(std::string_view& word) {
+        if (atEnd()) {
+            return false;
+        }
+
+        const char* begin = pos_;
+        while (pos_ < end_ && static_cast<unsigned char>(*pos_) > ' ') {
+            pos_++;
+        }
+        word = std::string_view(begin, pos_ - begin);
+        return true;
+    }
+
+    bool read(std::string& word) {
+        std::string_view view;
+        if (!read(view)) {
+            return false;
+        }
+        word.assign(view);
+        return true;
+    }
+
+    // Пропускаем пробелы; true, если ввод закончился.
+    bool atEnd() {
+        while (pos_ < end_ && static_cast<unsigned char>(*pos_) <= ' ') {
+            pos_++;
+        }
+        return pos_ == end_;
+    }
+
+    // Считываем массив в привычном для наших программ формате:
+    // сначала количество элементов n, потом сами элементы.
+    // Пустой ввод -- это пустой массив. Если же вместо числа встретилось
+    // что-то другое или ввод кончился раньше, чем прочитано n элементов,
+    // бросается std::runtime_error.
+    template<class T>
+    std::vector<T> readArray() {
+        size_t n = 0;
+        if (!read(n)) {
+            if (atEnd()) {
+                return {};
+            }
+            throw std::runtime_error("invalid element count: " + std::string(nextToken()));
+        }
+
+        // указываем capacity = n, тем самым сразу аллоцировав место под n элеметов
+        // (но не больше, чем элементов может поместиться в оставшемся вводе:
+        // на каждый нужен хотя бы символ и разделитель)
+        std::vector<T> arr;
+        arr.reserve(std::min<size_t>(n, (end_ - pos_) / 2 + 1));
+
+        T num;
+        for (size_t i = 0; i < n; i++) {
+            if (!read(num)) {
+                if (atEnd()) {
+                    throw std::runtime_error("input ended after " + std::to_string(i) + " of " +
+                                             std::to_string(n) + " elements");
+                }
+                throw std::runtime_error("invalid element #" + std::to_string(i + 1) + ": " +
+                                         std::string(nextToken()));
+            }
+            arr.push_back(num);
+        }
+        return arr;
+    }
+
+private:
+    // Кончается ли слово в позиции p (дальше пробел или конец ввода).
+    bool isTokenEnd(const char* p) const {
+        return p == end_ || static_cast<unsigned char>(*p) <= ' ';
+    }
+
+    // Следующее слово ввода без сдвига позиции (для сообщений об ошибках).
+    std::string_view nextToken() const {
+        const char* p = pos_;
+        while (p < end_ && static_cast<unsigned char>(*p) > ' ') {
+            p++;
+        }
+        return std::string_view(pos_, p - pos_);
+    }
+
+    static uint64_t load8(const char* p) {
+        uint64_t chunk;
+        std::memcpy(&chunk, p, 8);
+        return chunk;
+    }
+
+    // Все ли восемь байт -- цифры '0'..'9': старшая половина каждого байта
+    // равна 3, и после прибавления 6 к каждому байту она всё ещё равна 3.
+    static bool isEightDigits(uint64_t chunk) {
+        return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+                (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+    }
+
+    // Восемь цифр -> число: сначала складываем соседние цифры в двузначные
+    // числа, затем двузначные в четырёхзначные и четырёхзначные в восьмизначное.
+    static uint64_t parseEightDigits(uint64_t chunk) {
+        chunk -= 0x3030303030303030;
+        chunk = (chunk * 10) + (chunk >> 8);
+        return (((chunk & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+                (((chunk >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+    }
+
+    std::vector<char> buffer_;
+    void* mapped_ = nullptr;
+    size_t mappedSize_ = 0;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+};
+
+// Буферизованный вывод в стандартный вывод.
+class FastOutput {
+public:
+    FastOutput() : buffer_(bufferSize) {}
+
+    ~FastOutput() {
+        flush();
+    }
+
+    FastOutput(const FastOutput&) = delete;
+    FastOutput& operator=(const FastOutput&) = delete;
+
+    void write(char c) {
+        reserve(1);
+        buffer_[used_++] = c;
+    }
+
+    void write(std::string_view text) {
+        // Длинный текст, не влезающий в буфер, отдаём по частям.
+        while (!text.empty()) {
+            reserve(1);
+            size_t chunk = std::min(text.size(), buffer_.size() - used_);
+            std::memcpy(buffer_.data() + used_, text.data(), chunk);
+            used_ += chunk;
+            text.remove_prefix(chunk);
+        }
+    }
+
+    template<class T>
+    requires std::integral<T> || std::floating_point<T>
+    void write(T value) {
+        // Самое длинное число -- double в экспоненциальной записи, ~25 символов.
+        reserve(32);
+        auto [next, error] = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value);
+        used_ = next - buffer_.data();
+    }
+
+    // Выводим массив в привычном для наших программ формате:
+    // элементы через пробел и перевод строки в конце.
+    template<class T>
+    void writeArray(std::span<const T> arr) {
+        for (const T& num : arr) {
+            write(num);
+            write(' ');
+        }
+        write('\n');
+    }
+
+    void flush() {
+        // Сначала выталкиваем то, что могло остаться в std::cout.
+        std::cout.flush();
+
+        size_t written = 0;
+        while (written < used_) {
+            ssize_t got = ::write(STDOUT_FILENO, buffer_.data() + written, used_ - written);
+            if (got <= 0) {
+                break;
+            }
+            written += got;
+        }
+        used_ = 0;
+    }
+
+private:
+    static constexpr size_t bufferSize = size_t{1} << 20;
+
+    void reserve(size_t bytes) {
+        if (used_ + bytes > buffer_.size()) {
+            flush();
+        }
+    }
+
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+};
+
+// Замеряем, сколько микросекунд выполняется f.
+template<class F>
+long long measureMicroseconds(F&& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+// Время этапов работы программы. Выводится в stderr по флагу --timings,
+// чтобы не мешать выводу в stdout (его читает, например, report.py).
+struct PhaseTimings {
+    long long parse = 0;
+    long long sort = 0;
+    long long write = 0;
+
+    void report() const {
+        std::cerr << "parse: " << parse << " us\n"
+                  << "sort: " << sort << " us\n"
+                  << "write: " << write << " us" << std::endl;
+    }
+};
+
+// Числовое значение флага командной строки (--threads 4). В отличие от
+// std::stoul не принимает "-1", "4x" и пустую строку, а при ошибке бросает
+// std::invalid_argument с именем флага в сообщении.
+inline size_t parseFlagValue(std::string_view flag, std::string_view text) {
+    size_t value = 0;
+    auto [next, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || error != std::errc() || next != text.data() + text.size()) {
+        throw std::invalid_argument("invalid value for " + std::string(flag) + ": " + std::string(text));
+    }
+    return value;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "radix-key.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Косвенная сортировка -- для "тяжёлых" элементов (широких структур, строк).
+//
+// Сортировки перемещают элементы O(n log n) раз, и если элемент занимает
+// сотни байт, почти всё время уходит на их копирование. Поэтому сортируем не
+// сами элементы, а компактные записи "префикс ключа + указатель на элемент"
+// (16 байт) любой из наших сортировок, а затем переставляем элементы по
+// полученной перестановке за один проход, следуя по её циклам: каждый элемент
+// перемещается сразу на своё место, т.е. ровно один раз (и ещё по одному
+// перемещению через временную переменную на каждый цикл).
+//
+// Префикс -- это 64-битное число, порядок которого согласован с порядком
+// элементов: если prefix(a) < prefix(b), то b < a неверно. Большинство
+// сравнений решается по префиксам, которые лежат прямо в записях, и только при
+// равных префиксах приходится обращаться к самим элементам.
+
+// Префикс ключа по умолчанию: для чисел -- их ключ поразрядной сортировки
+// (radixKey: у целых перевёрнут знаковый бит, у чисел с плавающей точкой --
+// полный порядок IEEE-754, так что -0.0 встаёт перед +0.0, а NaN -- по краям),
+// для строк -- первые 8 байт (строки сравниваются побайтово как unsigned char,
+// поэтому байты укладываются в число от старшего к младшему). Для остальных
+// типов префикса нет (0), и сравниваются сами элементы; для своего типа можно
+// объявить рядом с ним перегрузку indirectKeyPrefix, она найдётся по типу
+// аргумента.
+template<class T>
+uint64_t indirectKeyPrefix(const T& value) {
+    if constexpr (RadixSortable<T>) {
+        return radixKey(value);
+    } else if constexpr (std::convertible_to<const T&, std::string_view>) {
+        std::string_view s = value;
+        uint64_t key = 0;
+        for (size_t i = 0; i < sizeof(uint64_t); i++) {
+            key <<= 8;
+            if (i < s.size()) {
+                key |= static_cast<unsigned char>(s[i]);
+            }
+        }
+        return key;
+    } else {
+        return 0;
+    }
+}
+
+// Запись, которую сортируем вместо элемента.
+template<class T>
+struct IndirectEntry {
+    uint64_t prefix = 0;
+    const T* element = nullptr;
+
+    friend bool operator<(const IndirectEntry& a, const IndirectEntry& b) {
+        if (a.prefix != b.prefix) {
+            return a.prefix < b.prefix;
+        }
+        return *a.element < *b.element;
+    }
+
+    friend bool operator>(const IndirectEntry& a, const IndirectEntry& b) {
+        return b < a;
+    }
+
+    friend bool operator<=(const IndirectEntry& a, const IndirectEntry& b) {
+        return !(b < a);
+    }
+
+    friend bool operator>=(const IndirectEntry& a, const IndirectEntry& b) {
+        return !(a < b);
+    }
+};
+
+// Переставляем arr на месте так, чтобы arr[i] стал прежним arr[order[i]].
+// Перестановка раскладывается на циклы: первый элемент цикла уходит во
+// временную переменную, на его место встаёт тот, кто должен там стоять, на
+// освободившееся место -- следующий и так далее, пока цикл не замкнётся.
+// Пройденные позиции отмечаются в самом order (order[i] = i), так что
+// дополнительной памяти не нужно, но order портится.
+template<class T>
+void applyPermutation(std::span<T> arr, std::span<size_t> order) {
+    for (size_t start = 0; start < arr.size(); start++) {
+        if (order[start] == start) {
+            continue;
+        }
+
+        T value = std::move(arr[start]);
+        size_t hole = start;
+        while (order[hole] != start) {
+            size_t next = order[hole];
+            arr[hole] = std::move(arr[next]);
+            order[hole] = hole;
+            hole = next;
+        }
+        arr[hole] = std::move(value);
+        order[hole] = hole;
+    }
+}
+
+// Косвенная сортировка arr: sort -- любая из сортировок (принимает
+// std::span<IndirectEntry<T>>), prefix -- префикс ключа (см. indirectKeyPrefix).
+// Если sort устойчива, то и косвенная сортировка устойчива.
+template<class T, class Sort, class Prefix>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void sortIndirect(std::span<T> arr, Sort&& sort, Prefix&& prefix) {
+    std::vector<IndirectEntry<T>> entries(arr.size());
+    for (size_t i = 0; i < arr.size(); i++) {
+        entries[i] = {static_cast<uint64_t>(prefix(arr[i])), &arr[i]};
+    }
+
+    sort(std::span<IndirectEntry<T>>(entries));
+
+    std::vector<size_t> order(arr.size());
+    for (size_t i = 0; i < arr.size(); i++) {
+        order[i] = static_cast<size_t>(entries[i].element - arr.data());
+    }
+    entries = {};
+
+    applyPermutation(arr, std::span<size_t>(order));
+}
+
+template<class T, class Sort>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void sortIndirect(std::span<T> arr, Sort&& sort) {
+    sortIndirect(arr, std::forward<Sort>(sort), [](const T& value) { return indirectKeyPrefix(value); });
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <utility>
+
+// Сортировка вставками. На маленьких массивах она быстрее всех: никаких
+// рекурсивных вызовов, а данные лежат в одной-двух кэш-линиях. Поэтому её
+// используют для досортировки маленьких частей и быстрая сортировка, и
+// сортировка слиянием. Она устойчива: элемент сдвигается только мимо строго
+// больших.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void insertionSort(std::span<T> arr) {
+    for (size_t i = 1; i < arr.size(); i++) {
+        T value = std::move(arr[i]);
+
+        size_t j = i;
+        while (j > 0 && value < arr[j - 1]) {
+            arr[j] = std::move(arr[j - 1]);
+            j--;
+        }
+        arr[j] = std::move(value);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Беззнаковый ключ числа, порядок которого совпадает с порядком самих чисел.
+// На нём держатся поразрядные сортировки и сортировка подсчётом, а косвенная
+// сортировка берёт его префиксом ключа (см. indirect-sort.hpp).
+
+// Типы, которые можно сортировать поразрядно: любые целые (кроме bool)
+// и числа с плавающей точкой в формате IEEE-754 одинарной и двойной точности.
+template<class T>
+concept RadixSortable =
+    (std::integral<T> && !std::same_as<T, bool>) ||
+    (std::floating_point<T> && std::numeric_limits<T>::is_iec559 && (sizeof(T) == 4 || sizeof(T) == 8));
+
+// Беззнаковое целое той же ширины, что и T.
+template<RadixSortable T>
+using RadixKey = std::conditional_t<
+    std::integral<T>,
+    std::make_unsigned<std::conditional_t<std::integral<T>, T, int>>,
+    std::conditional<sizeof(T) == 4, uint32_t, uint64_t>
+>::type;
+
+// Переводим значение в беззнаковый ключ так, чтобы порядок ключей совпадал с
+// порядком исходных значений. Тогда поразрядная сортировка ключей сортирует
+// и сами значения, и линейное время сохраняется для любого из этих типов.
+template<RadixSortable T>
+constexpr RadixKey<T> radixKey(T value) {
+    using K = RadixKey<T>;
+    constexpr K signBit = K{1} << (sizeof(K) * 8 - 1);
+
+    if constexpr (std::unsigned_integral<T>) {
+        return value;
+    } else if constexpr (std::signed_integral<T>) {
+        // В дополнительном коде отрицательные числа имеют старший бит 1, поэтому
+        // как беззнаковые они "больше" положительных. Инвертируем знаковый бит:
+        // -2^31 превращается в 0, -1 в 2^31 - 1, 0 в 2^31 -- порядок сохраняется.
+        return static_cast<K>(static_cast<K>(value) ^ signBit);
+    } else {
+        // У положительных чисел IEEE-754 порядок битовых представлений совпадает
+        // с порядком значений, достаточно поднять знаковый бит. Отрицательные
+        // хранятся как модуль со знаком, их порядок обратный -- инвертируем все биты.
+        // Получается полный порядок IEEE-754: -NaN < -inf < ... < -0.0 < +0.0 < ... < +inf < +NaN.
+        K bits = std::bit_cast<K>(value);
+        K mask = static_cast<K>(-(bits >> (sizeof(K) * 8 - 1))) | signBit;
+        return bits ^ mask;
+    }
+}
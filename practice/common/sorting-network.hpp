@@ -0,0 +1,390 @@
+#pragma once
+
+#include "insertion-sort.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SORTING_NETWORK_X86 1
+#include <immintrin.h>
+#endif
+
+// Векторные сети сортировки для маленьких массивов -- базовый случай быстрой
+// сортировки и сортировки слиянием.
+//
+// Сортировка вставками на последних уровнях рекурсии почти вся состоит из
+// непредсказуемых условных переходов. Сеть сортировки -- это фиксированная
+// последовательность операций "сравнить и упорядочить пару", которая не
+// зависит от данных, поэтому её можно выполнять векторными min/max без единого
+// ветвления, по 4-8 пар за инструкцию.
+//
+// Здесь используется битоническая сеть на N = 2^m элементах (N <= 64). Массив
+// из n <= N элементов дополняется до N наибольшими значениями типа, загружается
+// в регистры (W элементов в регистре) и сортируется прямо в них:
+//   - на шагах, где сравниваются элементы на расстоянии j >= W, пары -- это
+//     одинаковые позиции двух регистров, и шаг -- просто min и max регистров;
+//   - на шагах с j < W пары лежат в одном регистре: регистр переставляется
+//     (элемент l меняется местами с l ^ j), берутся min и max с исходным, и
+//     каждая позиция маской выбирает нужное из двух.
+// Реализации две -- для AVX2 (W = 256 бит) и SSE4.2 (W = 128 бит), а нужная
+// выбирается при первом вызове по возможностям процессора. Если нет ни той,
+// ни другой (или это не x86), массив сортируется вставками.
+
+// Наибольший размер массива, который сортируется сетью.
+constexpr size_t SORTING_NETWORK_MAX = 64;
+
+// Типы, для которых есть векторные сети.
+template<class T>
+concept SortingNetworkType =
+    std::same_as<T, int32_t> || std::same_as<T, int64_t> || std::same_as<T, float> || std::same_as<T, double>;
+
+#ifdef SORTING_NETWORK_X86
+
+// Вспомогательные функции ниже собраны без -mavx2 и получают и возвращают
+// векторные регистры. GCC предупреждает, что у таких функций другое ABI, но
+// все они встраиваются в sortNetworkAvx2 и sortNetworkSse42 (always_inline) и
+// отдельно не вызываются.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+// Набор инструкций, которым сортируем.
+enum class SortingNetworkIsa {
+    Scalar,
+    Sse42,
+    Avx2,
+};
+
+inline SortingNetworkIsa sortingNetworkIsa() {
+    static const SortingNetworkIsa isa = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SortingNetworkIsa::Avx2;
+        }
+        if (__builtin_cpu_supports("sse4.2")) {
+            return SortingNetworkIsa::Sse42;
+        }
+        return SortingNetworkIsa::Scalar;
+    }();
+    return isa;
+}
+
+// Операции над регистром AVX2 из элементов типа T. Все значения хранятся как
+// __m256i, для float и double -- через приведение типов (оно ничего не стоит).
+template<class T>
+struct Avx2Network {
+    using Reg = __m256i;
+    static constexpr size_t W = 32 / sizeof(T);
+
+    __attribute__((target("avx2"))) static Reg load(const T* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+
+    __attribute__((target("avx2"))) static void store(T* p, Reg v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+
+    // Поэлементные минимум и максимум. У чисел с плавающей точкой при
+    // равенстве оба возвращают b -- на этом держится то, что сеть не теряет
+    // значений вроде -0.0 и +0.0 (см. bitonicNetwork).
+    __attribute__((target("avx2"))) static Reg min(Reg a, Reg b) {
+        if constexpr (std::same_as<T, int32_t>) {
+            return _mm256_min_epi32(a, b);
+        } else if constexpr (std::same_as<T, float>) {
+            return _mm256_castps_si256(_mm256_min_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+        } else if constexpr (std::same_as<T, double>) {
+            return _mm256_castpd_si256(_mm256_min_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+        } else {
+            return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+        }
+    }
+
+    __attribute__((target("avx2"))) static Reg max(Reg a, Reg b) {
+        if constexpr (std::same_as<T, int32_t>) {
+            return _mm256_max_epi32(a, b);
+        } else if constexpr (std::same_as<T, float>) {
+            return _mm256_castps_si256(_mm256_max_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+        } else if constexpr (std::same_as<T, double>) {
+            return _mm256_castpd_si256(_mm256_max_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+        } else {
+            return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+        }
+    }
+
+    // Меняем местами элементы l и l ^ j.
+    __attribute__((target("avx2"))) static Reg permuteXor(Reg v, size_t j) {
+        // Переставляем 32-битные части: у 8-байтных элементов их по две.
+        const Reg lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        Reg index = _mm256_xor_si256(lanes, _mm256_set1_epi32(static_cast<int>(j * sizeof(T) / 4)));
+        return _mm256_permutevar8x32_epi32(v, index);
+    }
+
+    // Маска позиций l, для которых бит bit у номера элемента first + l равен 1.
+    __attribute__((target("avx2"))) static Reg bitMask(size_t first, size_t bit) {
+        if constexpr (sizeof(T) == 4) {
+            Reg index = _mm256_add_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(first)));
+            Reg b = _mm256_set1_epi32(static_cast<int>(bit));
+            return _mm256_cmpeq_epi32(_mm256_and_si256(index, b), b);
+        } else {
+            Reg index = _mm256_add_epi64(_mm256_setr_epi64x(0, 1, 2, 3), _mm256_set1_epi64x(static_cast<long long>(first)));
+            Reg b = _mm256_set1_epi64x(static_cast<long long>(bit));
+            return _mm256_cmpeq_epi64(_mm256_and_si256(index, b), b);
+        }
+    }
+
+    __attribute__((target("avx2"))) static Reg select(Reg a, Reg b, Reg mask) {
+        return _mm256_blendv_epi8(a, b, mask);
+    }
+
+    __attribute__((target("avx2"))) static Reg maskXor(Reg a, Reg b) {
+        return _mm256_xor_si256(a, b);
+    }
+};
+
+// То же для регистров SSE (128 бит, нужен SSE4.2 ради сравнения 64-битных целых).
+template<class T>
+struct Sse42Network {
+    using Reg = __m128i;
+    static constexpr size_t W = 16 / sizeof(T);
+
+    __attribute__((target("sse4.2"))) static Reg load(const T* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    __attribute__((target("sse4.2"))) static void store(T* p, Reg v) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+    }
+
+    __attribute__((target("sse4.2"))) static Reg min(Reg a, Reg b) {
+        if constexpr (std::same_as<T, int32_t>) {
+            return _mm_min_epi32(a, b);
+        } else if constexpr (std::same_as<T, float>) {
+            return _mm_castps_si128(_mm_min_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+        } else if constexpr (std::same_as<T, double>) {
+            return _mm_castpd_si128(_mm_min_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+        } else {
+            return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(a, b));
+        }
+    }
+
+    __attribute__((target("sse4.2"))) static Reg max(Reg a, Reg b) {
+        if constexpr (std::same_as<T, int32_t>) {
+            return _mm_max_epi32(a, b);
+        } else if constexpr (std::same_as<T, float>) {
+            return _mm_castps_si128(_mm_max_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+        } else if constexpr (std::same_as<T, double>) {
+            return _mm_castpd_si128(_mm_max_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+        } else {
+            return _mm_blendv_epi8(b, a, _mm_cmpgt_epi64(a, b));
+        }
+    }
+
+    // Меняем местами элементы l и l ^ j (перестановкой байтов).
+    __attribute__((target("sse4.2"))) static Reg permuteXor(Reg v, size_t j) {
+        const Reg bytes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        Reg index = _mm_xor_si128(bytes, _mm_set1_epi8(static_cast<char>(j * sizeof(T))));
+        return _mm_shuffle_epi8(v, index);
+    }
+
+    __attribute__((target("sse4.2"))) static Reg bitMask(size_t first, size_t bit) {
+        if constexpr (sizeof(T) == 4) {
+            Reg index = _mm_add_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(static_cast<int>(first)));
+            Reg b = _mm_set1_epi32(static_cast<int>(bit));
+            return _mm_cmpeq_epi32(_mm_and_si128(index, b), b);
+        } else {
+            Reg index = _mm_add_epi64(_mm_set_epi64x(1, 0), _mm_set1_epi64x(static_cast<long long>(first)));
+            Reg b = _mm_set1_epi64x(static_cast<long long>(bit));
+            return _mm_cmpeq_epi64(_mm_and_si128(index, b), b);
+        }
+    }
+
+    __attribute__((target("sse4.2"))) static Reg select(Reg a, Reg b, Reg mask) {
+        return _mm_blendv_epi8(a, b, mask);
+    }
+
+    __attribute__((target("sse4.2"))) static Reg maskXor(Reg a, Reg b) {
+        return _mm_xor_si128(a, b);
+    }
+};
+
+// Битоническая сеть на N элементах, лежащих в регистрах regs.
+// Элемент i лежит в регистре i / W на позиции i % W. В блоке из k элементов
+// (k = 2, 4, ..., N) пары на расстоянии j упорядочиваются по возрастанию,
+// если бит k номера элемента равен 0, и по убыванию иначе.
+// Равные, но различимые значения (-0.0 и +0.0) не должны размножаться:
+// поэтому min и max пары берутся с таким порядком аргументов, чтобы при
+// равенстве одна сторона получила одно значение, а другая -- другое.
+template<class Net, size_t N>
+__attribute__((always_inline)) inline void bitonicNetwork(typename Net::Reg* regs) {
+    constexpr size_t W = Net::W;
+    constexpr size_t R = N / W;
+
+    for (size_t k = 2; k <= N; k *= 2) {
+        for (size_t j = k / 2; j > 0; j /= 2) {
+            if (j >= W) {
+                // Пары -- одинаковые позиции регистров r и r + j / W.
+                const size_t jr = j / W;
+                for (size_t r = 0; r < R; r++) {
+                    if ((r & jr) != 0) {
+                        continue;
+                    }
+                    typename Net::Reg a = regs[r];
+                    typename Net::Reg b = regs[r + jr];
+                    typename Net::Reg lo = Net::min(a, b);
+                    typename Net::Reg hi = Net::max(b, a);
+                    const bool ascending = ((r * W) & k) == 0;
+                    regs[r] = ascending ? lo : hi;
+                    regs[r + jr] = ascending ? hi : lo;
+                }
+            } else {
+                // Пары -- позиции l и l ^ j одного регистра. Позиция берёт
+                // максимум, если она старшая в паре при возрастании или
+                // младшая при убывании.
+                for (size_t r = 0; r < R; r++) {
+                    typename Net::Reg v = regs[r];
+                    typename Net::Reg partner = Net::permuteXor(v, j);
+                    typename Net::Reg lo = Net::min(v, partner);
+                    typename Net::Reg hi = Net::max(v, partner);
+                    typename Net::Reg takeMax = Net::maskXor(Net::bitMask(r * W, j), Net::bitMask(r * W, k));
+                    regs[r] = Net::select(lo, hi, takeMax);
+                }
+            }
+        }
+    }
+}
+
+// Сортируем buffer из N элементов (N -- степень двойки, не меньше W).
+template<class Net, class T, size_t N>
+__attribute__((always_inline)) inline void sortNetworkBlock(T* buffer) {
+    typename Net::Reg regs[N / Net::W];
+    for (size_t r = 0; r < N / Net::W; r++) {
+        regs[r] = Net::load(buffer + r * Net::W);
+    }
+    bitonicNetwork<Net, N>(regs);
+    for (size_t r = 0; r < N / Net::W; r++) {
+        Net::store(buffer + r * Net::W, regs[r]);
+    }
+}
+
+// Выбираем сеть размера size среди N, 2N, ..., SORTING_NETWORK_MAX. Размер сети
+// должен быть известен при компиляции, чтобы все циклы развернулись, а
+// регистры не уходили в память.
+template<class Net, class T, size_t N>
+__attribute__((always_inline)) inline void sortNetworkOfSize(T* buffer, size_t size) {
+    if (size == N) {
+        sortNetworkBlock<Net, T, N>(buffer);
+    } else if constexpr (2 * N <= SORTING_NETWORK_MAX) {
+        sortNetworkOfSize<Net, T, 2 * N>(buffer, size);
+    }
+}
+
+// Дополняем arr до ближайшей степени двойки наибольшими значениями,
+// сортируем сетью и переписываем обратно первые arr.size() элементов.
+template<class Net, class T>
+__attribute__((always_inline)) inline void sortNetworkPadded(std::span<T> arr) {
+    alignas(64) T buffer[SORTING_NETWORK_MAX];
+    const T padding = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+
+    const size_t n = arr.size();
+    size_t size = Net::W;
+    while (size < n) {
+        size *= 2;
+    }
+
+    std::memcpy(buffer, arr.data(), n * sizeof(T));
+    std::fill(buffer + n, buffer + size, padding);
+
+    sortNetworkOfSize<Net, T, Net::W>(buffer, size);
+
+    std::memcpy(arr.data(), buffer, n * sizeof(T));
+}
+
+template<class T>
+__attribute__((target("avx2"))) void sortNetworkAvx2(std::span<T> arr) {
+    sortNetworkPadded<Avx2Network<T>>(arr);
+}
+
+template<class T>
+__attribute__((target("sse4.2"))) void sortNetworkSse42(std::span<T> arr) {
+    sortNetworkPadded<Sse42Network<T>>(arr);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+// Сортировка массива не длиннее SORTING_NETWORK_MAX векторной сетью (или
+// вставками, если процессор не поддерживает нужных инструкций).
+// Сеть не устойчива, но равные значения этих типов неразличимы -- кроме
+// -0.0 и +0.0, которые могут поменяться местами.
+// NaN не упорядочен векторными min/max: он может уйти в дополнение и
+// смениться на +inf, т.е. пропасть из массива. Поэтому массив с NaN
+// сортируется вставками -- она только переставляет элементы.
+template<SortingNetworkType T>
+void sortNetwork(std::span<T> arr) {
+    if constexpr (std::floating_point<T>) {
+        // Без раннего выхода, чтобы проверка векторизовалась.
+        bool hasNan = false;
+        for (T value : arr) {
+            hasNan |= value != value;
+        }
+        if (hasNan) {
+            insertionSort(arr);
+            return;
+        }
+    }
+
+#ifdef SORTING_NETWORK_X86
+    switch (sortingNetworkIsa()) {
+        case SortingNetworkIsa::Avx2:
+            sortNetworkAvx2(arr);
+            return;
+        case SortingNetworkIsa::Sse42:
+            sortNetworkSse42(arr);
+            return;
+        case SortingNetworkIsa::Scalar:
+            break;
+    }
+#endif
+    insertionSort(arr);
+}
+
+// Базовый случай сортировок: маленький массив сортируется сетью, если для
+// его типа она есть, иначе вставками.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void smallSort(std::span<T> arr) {
+    if constexpr (SortingNetworkType<T>) {
+        if (arr.size() > 1 && arr.size() <= SORTING_NETWORK_MAX) {
+            sortNetwork(arr);
+            return;
+        }
+    }
+    insertionSort(arr);
+}
+
+// То же для устойчивых сортировок: сетью сортируются только целые (у чисел с
+// плавающей точкой равные -0.0 и +0.0 различимы, и сеть могла бы их переставить).
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void smallSortStable(std::span<T> arr) {
+    if constexpr (SortingNetworkType<T> && std::integral<T>) {
+        if (arr.size() > 1 && arr.size() <= SORTING_NETWORK_MAX) {
+            sortNetwork(arr);
+            return;
+        }
+    }
+    insertionSort(arr);
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing) для рекурсивных алгоритмов
+// вида "разделяй и властвуй".
+//
+// У каждого потока своя очередь задач. Новые задачи поток кладёт в конец своей
+// очереди и сам берёт их оттуда же (как стек): последняя порождённая задача --
+// самая маленькая, и её данные ещё лежат в кэше. Когда своя очередь пуста, поток
+// перехватывает задачу из начала чужой очереди -- там лежат самые старые, т.е.
+// самые крупные задачи, так что перехваты редки, а работа быстро расходится
+// по всем потокам.
+//
+// Поток, создавший пул, тоже участвует в работе: он пользуется очередью 0,
+// пока ждёт группу задач (см. TaskGroup::wait), поэтому для threadCount потоков
+// пул запускает только threadCount - 1 рабочих.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(size_t threadCount = std::thread::hardware_concurrency())
+        : queues_(std::max<size_t>(threadCount, 1)) {
+        for (size_t i = 0; i < queues_.size(); i++) {
+            queues_[i] = std::make_unique<Queue>();
+        }
+        for (size_t i = 1; i < queues_.size(); i++) {
+            workers_.emplace_back([this, i](std::stop_token stop) { workerLoop(stop, i); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        for (std::jthread& worker : workers_) {
+            worker.request_stop();
+        }
+        {
+            std::lock_guard lock(sleepMutex_);
+        }
+        sleepCondition_.notify_all();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Количество потоков, включая создавший пул.
+    size_t size() const {
+        return queues_.size();
+    }
+
+    // Кладём задачу в очередь текущего потока.
+    void submit(Task task) {
+        Queue& queue = *queues_[currentQueue()];
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        queued_.fetch_add(1, std::memory_order_release);
+
+        // Захватываем мьютекс, чтобы рабочий не уснул между проверкой queued_
+        // и ожиданием и не пропустил это уведомление.
+        {
+            std::lock_guard lock(sleepMutex_);
+        }
+        sleepCondition_.notify_one();
+    }
+
+    // Выполняем одну задачу: свою из конца очереди или чужую из начала.
+    // Возвращает false, если задач нет нигде.
+    bool runPendingTask() {
+        const size_t self = currentQueue();
+        Task task;
+        if (!popBack(*queues_[self], task)) {
+            bool stolen = false;
+            for (size_t k = 1; k < queues_.size() && !stolen; k++) {
+                stolen = popFront(*queues_[(self + k) % queues_.size()], task);
+            }
+            if (!stolen) {
+                return false;
+            }
+        }
+
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        task();
+        return true;
+    }
+
+    // Усыпляем вызывающий поток, пока в очередях нет задач и done() ложно.
+    // Тот, кто делает done() истинным, должен затем вызвать wakeAll().
+    template<class Done>
+    void sleepUntil(Done done) {
+        std::unique_lock lock(sleepMutex_);
+        sleepCondition_.wait(lock, [&]() {
+            return done() || queued_.load(std::memory_order_acquire) > 0;
+        });
+    }
+
+    // Будим все спящие потоки, чтобы они перепроверили свои условия.
+    void wakeAll() {
+        {
+            std::lock_guard lock(sleepMutex_);
+        }
+        sleepCondition_.notify_all();
+    }
+
+private:
+    // Очереди разных потоков лежат в разных кэш-линиях.
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    static bool popBack(Queue& queue, Task& task) {
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    static bool popFront(Queue& queue, Task& task) {
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    // Номер очереди текущего потока. Потоки не из пула работают с очередью 0.
+    size_t currentQueue() const {
+        return currentPool_ == this ? currentIndex_ : 0;
+    }
+
+    void workerLoop(std::stop_token stop, size_t index) {
+        currentPool_ = this;
+        currentIndex_ = index;
+
+        while (!stop.stop_requested()) {
+            if (runPendingTask()) {
+                continue;
+            }
+            std::unique_lock lock(sleepMutex_);
+            sleepCondition_.wait(lock, [&]() {
+                return stop.stop_requested() || queued_.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+    static inline thread_local const WorkStealingPool* currentPool_ = nullptr;
+    static inline thread_local size_t currentIndex_ = 0;
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    // Сколько задач лежит во всех очередях; рабочие спят, пока их нет.
+    std::atomic<size_t> queued_ = 0;
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCondition_;
+
+    // Объявлены последними, чтобы потоки завершились раньше, чем будут
+    // уничтожены очереди.
+    std::vector<std::jthread> workers_;
+};
+
+// Группа задач в пуле: run() запускает задачу, wait() дожидается всех
+// запущенных. Пока задачи группы не завершились, wait() не простаивает, а
+// выполняет задачи из очередей пула, поэтому ждать можно и изнутри задачи --
+// рекурсивный алгоритм не заблокирует пул. Если же задач в очередях нет (все
+// задачи группы уже выполняются в других потоках), wait() засыпает до
+// появления новой задачи или завершения группы, а не крутится вхолостую.
+// Если задача бросила исключение, wait() пробрасывает первое из них.
+class TaskGroup {
+public:
+    explicit TaskGroup(WorkStealingPool& pool) : pool_(pool) {}
+
+    // Исключение из деструктора бросить нельзя, поэтому здесь только ждём.
+    ~TaskGroup() {
+        waitAll();
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    template<class F>
+    void run(F&& f) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_.submit([this, f = std::forward<F>(f)]() mutable {
+            // Задача считается завершённой, даже если бросила исключение,
+            // иначе wait() ждал бы её вечно.
+            struct Finish {
+                TaskGroup& group;
+                ~Finish() {
+                    group.finish();
+                }
+            } finish{*this};
+
+            try {
+                f();
+            } catch (...) {
+                std::lock_guard lock(errorMutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+            }
+        });
+    }
+
+    void wait() {
+        waitAll();
+        std::lock_guard lock(errorMutex_);
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+private:
+    bool done() const {
+        return pending_.load(std::memory_order_acquire) == 0;
+    }
+
+    void waitAll() {
+        while (!done()) {
+            if (!pool_.runPendingTask()) {
+                pool_.sleepUntil([this]() { return done(); });
+            }
+        }
+    }
+
+    // Как только pending_ станет нулём, ожидающий может вернуться из wait()
+    // и уничтожить группу, поэтому пул берём заранее.
+    void finish() {
+        WorkStealingPool& pool = pool_;
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            pool.wakeAll();
+        }
+    }
+
+    WorkStealingPool& pool_;
+    std::atomic<size_t> pending_ = 0;
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+};
@@ -1,58 +1,167 @@
+#include "../../common/binary-array.hpp"
+#include "../../common/fast-io.hpp"
+#include "countsort.hpp"
+
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
-void countingSort(std::vector<int>& arr, int maxNumber) {
-    // в этом векторе будет хранится количество какого-либо числа в векторе arr
-    // (это число соответствует индексу numbersCount), мы сразу создаём maxNumber + 1
-    // элементов внутри вектора и заполняем их нулями (+1, потому что индексация с нуля)
-    std::vector<int> numbersCount(maxNumber + 1, 0);
+// Параметры запуска программы.
+struct Options {
+    bool benchmark_mode = false;
+
+    // --timings выводит в stderr время разбора ввода, сортировки и вывода
+    bool timings_mode = false;
+
+    // --binary FILE сортирует двоичный файл на месте вместо текстового ввода
+    // (тип элементов тогда берётся из заголовка файла, а не из --type)
+    std::string binary_path;
+
+    // количество потоков задаётся флагом --threads, по умолчанию сортируем в одном потоке
+    size_t threads = 1;
 
-    // подсчитываем количество каждого числа в arr
-    for (int num : arr) {
-        numbersCount[num]++;
+    // вместо отсортированного массива можно вывести только его распределение:
+    // --histogram -- пары "число количество" по возрастанию чисел,
+    // --distinct -- количество различных чисел,
+    // --top K -- K самых частых чисел с их количеством
+    bool histogram_mode = false;
+    bool distinct_mode = false;
+    size_t top = 0;
+};
+
+// Считываем, сортируем и выводим массив элементов типа T.
+template<CountingSortable T>
+int run(const Options& options) {
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
+
+    // считываем массив (минимум и максимум countingSort найдёт сама)
+    std::vector<T> arr;
+    try {
+        timings.parse = measureMicroseconds([&]() { arr = input.template readArray<T>(); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
-    // мы проходим по каждому индексу из maxNumber (значение по индексу содержит
-    // количество числа под индексом в arr), смотрим значение по индексу и
-    // записываем индекс в arr столько раз, сколько записано в значении по индексу
-    // (то есть столько, сколько раз число под индексом встречается в arr)
-    int arrIndex = 0;
-    for (int i = 0; i < maxNumber + 1; i++) {
-        for (int j = 0; j < numbersCount[i]; j++) {
-            arr[arrIndex++] = i;
+    if (options.histogram_mode || options.distinct_mode || options.top > 0) {
+        std::vector<ValueCount<T>> histogram;
+        timings.sort = measureMicroseconds([&]() {
+            histogram = countingHistogram(std::span<const T>(arr));
+            if (options.top > 0) {
+                histogram = topKFrequent(std::span<const ValueCount<T>>(histogram), options.top);
+            }
+        });
+
+        timings.write = measureMicroseconds([&]() {
+            if (options.distinct_mode) {
+                output.write(distinctCount(std::span<const ValueCount<T>>(histogram)));
+                output.write('\n');
+            } else {
+                for (auto [value, count] : histogram) {
+                    output.write(value);
+                    output.write(' ');
+                    output.write(count);
+                    output.write('\n');
+                }
+            }
+            output.flush();
+        });
+    } else {
+        // сортируем массив
+        timings.sort = measureMicroseconds([&]() {
+            if (options.threads > 1) {
+                countingSortParallel(std::span<T>(arr), options.threads);
+            } else {
+                countingSort(arr);
+            }
+        });
+
+        if (options.benchmark_mode) {
+            output.write(timings.sort);
+            output.write('\n');
+        } else {
+            // выводим массив на экран
+            timings.write = measureMicroseconds([&]() {
+                output.writeArray(std::span<const T>(arr));
+                output.flush();
+            });
         }
     }
-}
-
-int main() {
-    int n;  // кол-во элементов
-    std::cin >> n;
 
-    // указываем capacity = n, тем самым сразу аллоцировав место под n элеметов
-    std::vector<int> arr;
-    arr.reserve(n);
+    if (options.timings_mode) {
+        timings.report();
+    }
+    return 0;
+}
 
-    // при вводе чисел мы сразу найдём максимальное число, чтобы аллоцировать
-    // вектор нужной размерности
-    int maxNumber = -1;
+int main(int argc, char* argv[]) {
+    Options options;
 
-    // заполняем массив
-    for (int i = 0; i < n; i++) {
-        int num;
-        std::cin >> num;
-        arr.push_back(num);
+    // тип элементов можно указать флагом --type, по умолчанию это int;
+    // для 8- и 16-битных типов (u8, i8, u16, i16) подсчёт идёт отдельным ядром
+    std::string type = "i32";
 
-        if (num > maxNumber) {
-            maxNumber = num;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--benchmark") {
+                options.benchmark_mode = true;
+            } else if (arg == "--timings") {
+                options.timings_mode = true;
+            } else if (arg == "--type" && i + 1 < argc) {
+                type = argv[++i];
+            } else if (arg == "--binary" && i + 1 < argc) {
+                options.binary_path = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                options.threads = parseFlagValue(arg, argv[++i]);
+            } else if (arg == "--histogram") {
+                options.histogram_mode = true;
+            } else if (arg == "--distinct") {
+                options.distinct_mode = true;
+            } else if (arg == "--top" && i + 1 < argc) {
+                options.top = parseFlagValue(arg, argv[++i]);
+            }
         }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
-    // сортируем массив
-    countingSort(arr, maxNumber);
+    if (!options.binary_path.empty()) {
+        return sortBinaryFile(options.binary_path, options.benchmark_mode, options.timings_mode, [&options](auto arr) {
+            using T = typename decltype(arr)::value_type;
+            if constexpr (CountingSortable<T>) {
+                countingSortParallel(arr, options.threads);
+            } else {
+                throw std::runtime_error("counting sort supports only integer arrays");
+            }
+        });
+    }
 
-    // выводим массив на экран
-    for (int num : arr) {
-        std::cout << num << " ";
+    if (type == "i32") {
+        return run<int32_t>(options);
+    } else if (type == "i64") {
+        return run<int64_t>(options);
+    } else if (type == "u32") {
+        return run<uint32_t>(options);
+    } else if (type == "u64") {
+        return run<uint64_t>(options);
+    } else if (type == "u8") {
+        return run<uint8_t>(options);
+    } else if (type == "i8") {
+        return run<int8_t>(options);
+    } else if (type == "u16") {
+        return run<uint16_t>(options);
+    } else if (type == "i16") {
+        return run<int16_t>(options);
+    } else {
+        std::cerr << "Неизвестный тип: " << type << std::endl;
+        return 1;
     }
-    std::cout << std::endl;
 }
@@ -0,0 +1,395 @@
+#pragma once
+
+#include "../radix-sort-lsd/radixlsd.hpp"
+#include "../radix-sort-msd/radixmsd.hpp"
+
+#include <algorithm>
+#include <barrier>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+// COUNTING_SCALAR отключает векторное сложение гистограмм (для проверки
+// скалярного варианта на x86).
+#if defined(__SSE2__) && !defined(COUNTING_SCALAR)
+#define COUNTING_SSE2
+#include <emmintrin.h>
+#endif
+
+// Целые типы, которые умеет сортировать подсчётом (bool сюда не входит).
+template<class T>
+concept CountingSortable = std::integral<T> && RadixSortable<T>;
+
+// Диапазон значений, счётчики для которого всегда помещаются в L2-кэш:
+// такой диапазон выгоден при любом n.
+constexpr size_t COUNTING_SMALL_RANGE = size_t{1} << 15;
+
+// Во сколько раз диапазон значений может превышать количество элементов.
+// Сортировка подсчётом делает ~2n + range операций, поразрядная -- около 2n
+// на каждый проход (их до 8), поэтому при range порядка нескольких n
+// подсчёт ещё выигрывает, а дальше начинает проигрывать и по времени, и по памяти.
+constexpr size_t COUNTING_RANGE_FACTOR = 4;
+
+// Стоит ли сортировать подсчётом n элементов, у которых max - min == spread.
+inline bool countingSortFits(size_t n, uint64_t spread) {
+    return spread < COUNTING_SMALL_RANGE || spread / COUNTING_RANGE_FACTOR < n;
+}
+
+// Число, которому соответствует счётчик с индексом index. Складываем в
+// беззнаковых числах, чтобы не было переполнения знакового типа.
+template<CountingSortable T>
+T countingValue(T minNumber, size_t index) {
+    return static_cast<T>(static_cast<RadixKey<T>>(minNumber) + static_cast<RadixKey<T>>(index));
+}
+
+// Гистограмма для 8- и 16-битных чисел. Наивный цикл numbersCount[num]++
+// упирается в зависимость через память: если подряд идут одинаковые числа
+// (а в перекошенных данных это обычное дело), каждое следующее увеличение
+// ждёт, пока процессор запишет и снова прочитает тот же счётчик. Поэтому
+// соседние элементы считаются в разных, чередующихся гистограммах -- цепочки
+// зависимостей становятся в SubHistograms раз короче, и подсчёт идёт примерно
+// за такт на элемент при любом распределении. Затем гистограммы складываются
+// векторными инструкциями.
+//
+// Для 8-битных чисел берём 4 гистограммы (4 КиБ, помещаются в L1), для
+// 16-битных -- 2 (512 КиБ, помещаются в L2).
+template<CountingSortable T, size_t SubHistograms = (sizeof(T) == 1 ? 4 : 2)>
+requires (sizeof(T) <= 2)
+std::vector<size_t> smallHistogram(std::span<const T> arr) {
+    constexpr size_t range = size_t{1} << (8 * sizeof(T));
+
+    // Счётчики 32-битные, чтобы в векторный регистр их помещалось больше.
+    // Чтобы они не переполнились, массив обрабатывается блоками, после каждого
+    // блока частичные суммы переносятся в 64-битный результат.
+    constexpr size_t block = size_t{1} << 30;
+
+    std::vector<size_t> totals(range, 0);
+    std::vector<uint32_t> sub(SubHistograms * range);
+    std::vector<uint32_t> reduced(range);
+
+    for (size_t blockBegin = 0; blockBegin < arr.size(); blockBegin += block) {
+        std::span<const T> part = arr.subspan(blockBegin, std::min(block, arr.size() - blockBegin));
+        std::fill(sub.begin(), sub.end(), 0);
+
+        size_t i = 0;
+        for (; i + SubHistograms <= part.size(); i += SubHistograms) {
+            for (size_t k = 0; k < SubHistograms; k++) {
+                sub[k * range + radixKey(part[i + k])]++;
+            }
+        }
+        for (; i < part.size(); i++) {
+            sub[radixKey(part[i])]++;
+        }
+
+        size_t v = 0;
+#ifdef COUNTING_SSE2
+        for (; v + 4 <= range; v += 4) {
+            __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub.data() + v));
+            for (size_t k = 1; k < SubHistograms; k++) {
+                __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub.data() + k * range + v));
+                acc = _mm_add_epi32(acc, next);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(reduced.data() + v), acc);
+        }
+#endif
+        for (; v < range; v++) {
+            uint32_t acc = sub[v];
+            for (size_t k = 1; k < SubHistograms; k++) {
+                acc += sub[k * range + v];
+            }
+            reduced[v] = acc;
+        }
+
+        for (v = 0; v < range; v++) {
+            totals[v] += reduced[v];
+        }
+    }
+
+    return totals;
+}
+
+// Счётчики чисел массива: counts[i] -- сколько раз в массиве встречается
+// число countingValue(minNumber, i).
+template<CountingSortable T>
+struct CountingCounts {
+    T minNumber;
+    std::vector<size_t> counts;
+};
+
+// Подсчитываем числа массива. Счётчики заводятся не для [0; max], а только
+// для [min; max], поэтому отрицательные числа тоже поддерживаются, а память
+// пропорциональна разбросу значений, а не их величине. Если же разброс слишком
+// велик по сравнению с количеством элементов (например, в массив из 10 чисел
+// затесалось 2 миллиарда), то счётчики не заводятся вовсе и возвращается nullopt.
+template<CountingSortable T>
+std::optional<CountingCounts<T>> countingCounts(std::span<const T> arr) {
+    if (arr.empty()) {
+        return CountingCounts<T>{T{}, {}};
+    }
+
+    // Для 8- и 16-битных чисел есть специальное ядро подсчёта. Оно всегда
+    // заводит счётчики на весь диапазон типа, поэтому включается, только
+    // когда элементов достаточно, чтобы окупить обход этих счётчиков.
+    if constexpr (sizeof(T) <= 2) {
+        constexpr size_t range = size_t{1} << (8 * sizeof(T));
+        if (arr.size() >= range / COUNTING_RANGE_FACTOR) {
+            return CountingCounts<T>{std::numeric_limits<T>::min(), smallHistogram<T>(arr)};
+        }
+    }
+
+    auto [minIt, maxIt] = std::minmax_element(arr.begin(), arr.end());
+    const T minNumber = *minIt;
+
+    // Разброс считаем на беззнаковых ключах, чтобы max - min не переполнялось
+    // (например, для INT64_MIN и INT64_MAX).
+    const auto minKey = radixKey(minNumber);
+    const RadixKey<T> spread = radixKey(*maxIt) - minKey;
+    if (!countingSortFits(arr.size(), spread)) {
+        return std::nullopt;
+    }
+
+    // в этом векторе будет хранится количество каждого числа из arr, числу num
+    // соответствует индекс num - minNumber (+1, потому что обе границы включены)
+    std::vector<size_t> numbersCount(static_cast<size_t>(spread) + 1, 0);
+
+    // подсчитываем количество каждого числа в arr
+    for (T num : arr) {
+        numbersCount[radixKey(num) - minKey]++;
+    }
+
+    return CountingCounts<T>{minNumber, std::move(numbersCount)};
+}
+
+// Сортировка подсчётом. Если разброс значений слишком велик для счётчиков,
+// сортировка сама переключается на поразрядную, которой нужно O(n) памяти,
+// а совсем маленькие массивы досортировываются вставками.
+template<CountingSortable T>
+void countingSort(std::span<T> arr) {
+    if (arr.size() <= MSD_INSERTION_THRESHOLD) {
+        insertionSortByKey(arr, [](T value) { return value; });
+        return;
+    }
+
+    auto numbersCount = countingCounts(std::span<const T>(arr));
+    if (!numbersCount) {
+        radixLSDSort(arr);
+        return;
+    }
+
+    // мы проходим по каждому индексу counts, смотрим значение по индексу и
+    // записываем число minNumber + индекс в arr столько раз, сколько записано в
+    // значении по индексу (то есть столько, сколько раз оно встречается в arr).
+    // Записываем сразу целым блоком через fill_n, а не по одному элементу:
+    // такой цикл компилятор векторизует, и в нём нет ветвления на каждый элемент.
+    const auto& counts = numbersCount->counts;
+    size_t arrIndex = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        std::fill_n(arr.begin() + arrIndex, counts[i], countingValue(numbersCount->minNumber, i));
+        arrIndex += counts[i];
+    }
+}
+
+template<CountingSortable T>
+void countingSort(std::vector<T>& arr) {
+    countingSort(std::span<T>(arr));
+}
+
+// Число и сколько раз оно встречается в массиве.
+template<CountingSortable T>
+struct ValueCount {
+    T value;
+    size_t count;
+};
+
+// Отсортированный массив в сжатом виде: пары (число, количество) по
+// возрастанию чисел. Размер результата пропорционален количеству различных
+// чисел, а не n, поэтому, если нужна только форма распределения, сами n
+// элементов разворачивать не нужно. Массив arr при этом не меняется.
+template<CountingSortable T>
+std::vector<ValueCount<T>> countingHistogram(std::span<const T> arr) {
+    std::vector<ValueCount<T>> histogram;
+
+    if (auto numbersCount = countingCounts(arr)) {
+        const auto& counts = numbersCount->counts;
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (counts[i] > 0) {
+                histogram.push_back({countingValue(numbersCount->minNumber, i), counts[i]});
+            }
+        }
+        return histogram;
+    }
+
+    // Разброс слишком велик для счётчиков: сортируем копию поразрядно
+    // и сжимаем серии одинаковых чисел.
+    std::vector<T> sorted(arr.begin(), arr.end());
+    radixLSDSort(sorted);
+    for (T num : sorted) {
+        if (!histogram.empty() && histogram.back().value == num) {
+            histogram.back().count++;
+        } else {
+            histogram.push_back({num, 1});
+        }
+    }
+    return histogram;
+}
+
+// Количество различных чисел.
+template<CountingSortable T>
+size_t distinctCount(std::span<const ValueCount<T>> histogram) {
+    return histogram.size();
+}
+
+// k самых частых чисел по убыванию частоты (при равной частоте -- по
+// возрастанию числа). Работает за O(d log k), где d -- количество различных чисел.
+template<CountingSortable T>
+std::vector<ValueCount<T>> topKFrequent(std::span<const ValueCount<T>> histogram, size_t k) {
+    std::vector<ValueCount<T>> top(histogram.begin(), histogram.end());
+    k = std::min(k, top.size());
+
+    std::partial_sort(top.begin(), top.begin() + k, top.end(), [](const ValueCount<T>& a, const ValueCount<T>& b) {
+        return a.count > b.count || (a.count == b.count && a.value < b.value);
+    });
+    top.resize(k);
+    return top;
+}
+
+// Сколько элементов должно приходиться на один поток, чтобы его запуск
+// и синхронизация окупались.
+constexpr size_t COUNTING_PARALLEL_GRAIN = size_t{1} << 16;
+
+// Многопоточная сортировка подсчётом. Массив делится на threadCount кусков, и:
+//   1. каждый поток ищет минимум и максимум своего куска;
+//   2. каждый поток считает числа своего куска в собственной гистограмме --
+//      никаких атомарных операций и общих кэш-линий;
+//   3. гистограммы складываются: каждый поток суммирует свой отрезок счётчиков
+//      по всем потокам и сразу считает на нём префиксные суммы, а затем
+//      сдвигает их на сумму предыдущих отрезков -- получаем позицию в arr,
+//      с которой начинается каждое число;
+//   4. каждый поток заполняет свою n / threadCount часть arr блоками fill_n.
+//      Части делятся по позициям в выходном массиве, а не по значениям, поэтому
+//      нагрузка равномерна даже если почти все числа одинаковые.
+// Между этапами потоки ждут друг друга на барьере.
+template<CountingSortable T>
+void countingSortParallel(std::span<T> arr, size_t threadCount = std::thread::hardware_concurrency()) {
+    const size_t n = arr.size();
+    threadCount = std::clamp<size_t>(n / COUNTING_PARALLEL_GRAIN, 1, std::max<size_t>(threadCount, 1));
+    if (threadCount == 1) {
+        countingSort(arr);
+        return;
+    }
+
+    std::vector<T> mins(threadCount);
+    std::vector<T> maxs(threadCount);
+    std::vector<std::vector<size_t>> counts(threadCount);
+
+    // Общая гистограмма, которая после третьего этапа превращается в позиции начала чисел.
+    std::vector<size_t> starts;
+    std::vector<size_t> chunkSums(threadCount);
+
+    // Решение о переходе на поразрядную сортировку потоки принимают вместе,
+    // а саму поразрядную сортировку запускаем уже после их завершения.
+    bool fallback = false;
+
+    T minNumber{};
+    std::barrier sync(static_cast<std::ptrdiff_t>(threadCount), [&]() noexcept {
+        // Функция завершения барьера выполняется одним потоком, когда все дошли до барьера.
+        // Нужна она только после первого этапа -- выделить общие счётчики.
+        if (!starts.empty() || fallback) {
+            return;
+        }
+
+        minNumber = *std::min_element(mins.begin(), mins.end());
+        const RadixKey<T> spread = radixKey(*std::max_element(maxs.begin(), maxs.end())) - radixKey(minNumber);
+
+        // Каждый поток держит собственную гистограмму на весь разброс значений,
+        // поэтому разброс сравниваем с размером куска одного потока, а не с n.
+        if (!countingSortFits(n / threadCount, spread)) {
+            fallback = true;
+            return;
+        }
+        starts.resize(static_cast<size_t>(spread) + 1);
+    });
+
+    auto worker = [&](size_t t) {
+        const size_t begin = t * n / threadCount;
+        const size_t end = (t + 1) * n / threadCount;
+        std::span<T> slice = arr.subspan(begin, end - begin);
+
+        auto [minIt, maxIt] = std::minmax_element(slice.begin(), slice.end());
+        mins[t] = *minIt;
+        maxs[t] = *maxIt;
+        sync.arrive_and_wait();
+
+        if (fallback) {
+            return;
+        }
+
+        const auto minKey = radixKey(minNumber);
+        const size_t range = starts.size();
+        if constexpr (sizeof(T) <= 2) {
+            // Кусок потока не меньше COUNTING_PARALLEL_GRAIN элементов, этого
+            // хватает, чтобы окупить ядро с гистограммой на весь диапазон типа.
+            // Из неё берём только счётчики [min; max].
+            std::vector<size_t> full = smallHistogram<T>(std::span<const T>(slice));
+            counts[t].assign(full.begin() + minKey, full.begin() + minKey + range);
+        } else {
+            counts[t].assign(range, 0);
+            for (T num : slice) {
+                counts[t][radixKey(num) - minKey]++;
+            }
+        }
+        sync.arrive_and_wait();
+
+        // Складываем гистограммы на своём отрезке счётчиков и считаем префиксные суммы.
+        const size_t rangeBegin = t * range / threadCount;
+        const size_t rangeEnd = (t + 1) * range / threadCount;
+        size_t sum = 0;
+        for (size_t i = rangeBegin; i < rangeEnd; i++) {
+            size_t total = 0;
+            for (size_t u = 0; u < threadCount; u++) {
+                total += counts[u][i];
+            }
+            starts[i] = sum;
+            sum += total;
+        }
+        chunkSums[t] = sum;
+        sync.arrive_and_wait();
+
+        size_t base = 0;
+        for (size_t u = 0; u < t; u++) {
+            base += chunkSums[u];
+        }
+        for (size_t i = rangeBegin; i < rangeEnd; i++) {
+            starts[i] += base;
+        }
+        sync.arrive_and_wait();
+
+        // Ищем последнее число, которое начинается не позже begin, и заполняем
+        // [begin; end) числами подряд, обрезая их блоки по границам своей части.
+        size_t i = std::upper_bound(starts.begin(), starts.end(), begin) - starts.begin() - 1;
+        for (size_t pos = begin; pos < end; i++) {
+            size_t next = i + 1 < range ? starts[i + 1] : n;
+            size_t blockEnd = std::min(next, end);
+            std::fill(arr.begin() + pos, arr.begin() + blockEnd, countingValue(minNumber, i));
+            pos = blockEnd;
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(threadCount - 1);
+        for (size_t t = 1; t < threadCount; t++) {
+            threads.emplace_back(worker, t);
+        }
+        worker(0);
+    }
+
+    if (fallback) {
+        radixLSDSortParallel(arr, threadCount);
+    }
+}
@@ -1,68 +1,132 @@
-#include <vector>
-#include <array>
+#include "../../common/binary-array.hpp"
+#include "../../common/fast-io.hpp"
+#include "radixlsd.hpp"
+
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <span>
+#include <string>
+#include <vector>
 
-void radixLSDSort(std::vector<int>& arr, int maxNumber) {
-    // индекс массива векторов -- это цифра, которая содержится в разряде числа,
-    // этот разряд соответствует множителю multiplier
-    std::array<std::vector<int>, 10> buckets;
-    int multiplier = 1;
-
-    // цикл работает до тех пор, пока проверяемый разряд не станет старше, чем
-    // максимально страший разряд чисел из arr
-    while (maxNumber >= multiplier) {
-        // добавляем числа из arr в соответствующий вектор из массива векторов
-        for (int num : arr) {
-            buckets[num / multiplier % 10].push_back(num);
-        }
+// Параметры запуска программы.
+struct Options {
+    bool benchmark_mode = false;
+
+    // --timings выводит в stderr время разбора ввода, сортировки и вывода
+    bool timings_mode = false;
+
+    // количество потоков задаётся флагом --threads, по умолчанию сортируем в одном потоке
+    size_t threads = 1;
+
+    // --binary FILE сортирует двоичный файл на месте вместо текстового ввода
+    // (тип элементов тогда берётся из заголовка файла, а не из --type)
+    std::string binary_path;
+
+    // если argsort_mode включён, вместо отсортированного массива выводим
+    // перестановку индексов, которая его сортирует
+    bool argsort_mode = false;
+};
 
-        // переписываем в arr отсортированную по текущему разряду
-        // последовательность чисел
-        int arrIndex = 0;
-        for (auto& bucket : buckets) {
-            for (int num : bucket) {
-                arr[arrIndex++] = num;
+// Считываем, сортируем и выводим массив элементов типа T.
+template<RadixSortable T>
+int run(const Options& options) {
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
+
+    // считываем массив
+    std::vector<T> arr;
+    try {
+        timings.parse = measureMicroseconds([&]() { arr = input.template readArray<T>(); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (options.argsort_mode) {
+        std::vector<size_t> order;
+        timings.sort = measureMicroseconds([&]() { order = radixArgsort(std::span<const T>(arr)); });
+        timings.write = measureMicroseconds([&]() {
+            output.writeArray(std::span<const size_t>(order));
+            output.flush();
+        });
+    } else {
+        // сортируем массив
+        timings.sort = measureMicroseconds([&]() {
+            if (options.threads > 1) {
+                radixLSDSortParallel(std::span<T>(arr), options.threads);
+            } else {
+                radixLSDSort(arr);
             }
+        });
 
-            // очищаем вектор, чтобы его можно было переиспользовать
-            // на следующей итерации
-            bucket.clear();
+        if (options.benchmark_mode) {
+            output.write(timings.sort);
+            output.write('\n');
+        } else {
+            // выводим массив на экран
+            timings.write = measureMicroseconds([&]() {
+                output.writeArray(std::span<const T>(arr));
+                output.flush();
+            });
         }
+    }
 
-        // переходим к следующему разряду
-        multiplier *= 10;
+    if (options.timings_mode) {
+        timings.report();
     }
+    return 0;
 }
 
-int main() {
-    int n;  // кол-во элементов
-    std::cin >> n;
+int main(int argc, char* argv[]) {
+    Options options;
 
-    // указываем capacity = n, тем самым сразу аллоцировав место под n элеметов
-    std::vector<int> arr;
-    arr.reserve(n);
+    // тип элементов можно указать флагом --type, по умолчанию это int
+    std::string type = "i32";
 
-    // при вводе чисел мы сразу найдём максимальное число, чтобы аллоцировать
-    // вектор нужной размерности
-    int maxNumber = -1;
-
-    // заполняем массив
-    for (int i = 0; i < n; i++) {
-        int num;
-        std::cin >> num;
-        arr.push_back(num);
-
-        if (num > maxNumber) {
-            maxNumber = num;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--benchmark") {
+                options.benchmark_mode = true;
+            } else if (arg == "--timings") {
+                options.timings_mode = true;
+            } else if (arg == "--type" && i + 1 < argc) {
+                type = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                options.threads = parseFlagValue(arg, argv[++i]);
+            } else if (arg == "--binary" && i + 1 < argc) {
+                options.binary_path = argv[++i];
+            } else if (arg == "--argsort") {
+                options.argsort_mode = true;
+            }
         }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
-    // сортируем массив
-    radixLSDSort(arr, maxNumber);
+    if (!options.binary_path.empty()) {
+        return sortBinaryFile(options.binary_path, options.benchmark_mode, options.timings_mode, [&options](auto arr) {
+            radixLSDSortParallel(arr, options.threads);
+        });
+    }
 
-    // выводим массив на экран
-    for (int num : arr) {
-        std::cout << num << " ";
+    if (type == "i32") {
+        return run<int32_t>(options);
+    } else if (type == "i64") {
+        return run<int64_t>(options);
+    } else if (type == "u32") {
+        return run<uint32_t>(options);
+    } else if (type == "u64") {
+        return run<uint64_t>(options);
+    } else if (type == "f32") {
+        return run<float>(options);
+    } else if (type == "f64") {
+        return run<double>(options);
+    } else {
+        std::cerr << "Неизвестный тип: " << type << std::endl;
+        return 1;
     }
-    std::cout << std::endl;
 }
@@ -0,0 +1,370 @@
+#pragma once
+
+#include "../../common/radix-key.hpp"
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Сортировка идёт по байтам, а не по десятичным цифрам: одна "цифра" -- это 8 бит
+// ключа, поэтому корзин 256, а 32-битному числу нужно не 10 проходов, а всего 4.
+// К тому же цифра извлекается сдвигом и маской, а не делением на степень десятки.
+constexpr size_t RADIX_BITS = 8;
+constexpr size_t RADIX = size_t{1} << RADIX_BITS;
+
+// Размер буфера write-combining для одной корзины (две кэш-линии).
+constexpr size_t RADIX_STAGING_BYTES = 128;
+
+// Буферизовать запись имеет смысл только тогда, когда массив не помещается в кэш:
+// на маленьких массивах лишнее копирование стоит дороже, чем оно экономит.
+constexpr size_t RADIX_STAGING_THRESHOLD = size_t{1} << 16;
+
+// Гистограммы сразу для всех проходов: counts[pass][digit] -- сколько элементов
+// имеют цифру digit в байте номер pass (считая с младшего).
+template<std::unsigned_integral K>
+using RadixHistograms = std::array<std::array<size_t, RADIX>, sizeof(K)>;
+
+// Извлекаем цифру ключа для прохода, начинающегося с бита shift.
+template<std::unsigned_integral K>
+constexpr size_t radixDigit(K key, size_t shift) {
+    return static_cast<size_t>(key >> shift) & (RADIX - 1);
+}
+
+// Считаем гистограммы всех проходов за одно чтение массива. В исходной версии
+// массив перечитывался на каждом проходе, а здесь каждый следующий проход
+// уже знает, сколько элементов попадёт в каждую корзину.
+template<class T, class KeyFn, std::unsigned_integral K = std::invoke_result_t<KeyFn, const T&>>
+RadixHistograms<K> radixHistograms(std::span<const T> arr, KeyFn key) {
+    RadixHistograms<K> counts{};
+
+    for (const T& item : arr) {
+        K k = key(item);
+        for (size_t pass = 0; pass < sizeof(K); pass++) {
+            counts[pass][radixDigit(k, pass * RADIX_BITS)]++;
+        }
+    }
+
+    return counts;
+}
+
+// Префиксная сумма гистограммы: offsets[d] -- позиция, с которой начинается
+// корзина d в выходном массиве.
+inline std::array<size_t, RADIX> radixOffsets(const std::array<size_t, RADIX>& counts) {
+    std::array<size_t, RADIX> offsets;
+    size_t sum = 0;
+    for (size_t d = 0; d < RADIX; d++) {
+        offsets[d] = sum;
+        sum += counts[d];
+    }
+    return offsets;
+}
+
+// Один проход распределения: раскладываем элементы from в to по цифре,
+// начинающейся с бита shift. Распределение устойчивое -- элементы с одинаковой
+// цифрой сохраняют относительный порядок, на этом и держится LSD-сортировка.
+template<class T, class KeyFn>
+void radixScatter(
+    std::span<T> from,
+    std::span<T> to,
+
+    // offsets[d] -- позиция в to, куда попадёт следующий элемент с цифрой d.
+    // При однопоточной сортировке это просто префиксная сумма гистограммы,
+    // при многопоточной -- ещё и сдвиг на элементы предыдущих потоков.
+    std::array<size_t, RADIX> offsets,
+    size_t shift,
+    KeyFn key,
+
+    // Буфер для write-combining, его выделяет вызывающая сторона один раз
+    // на всю сортировку (может быть пустым, если буферизация не нужна).
+    std::span<T> staging
+) {
+    if (staging.empty()) {
+        for (T& item : from) {
+            to[offsets[radixDigit(key(item), shift)]++] = std::move(item);
+        }
+        return;
+    }
+
+    // При прямой записи каждый элемент летит в одну из 256 далеко разнесённых
+    // областей to. На массивах больше L3 это 256 активных страниц одновременно:
+    // промахи TLB и частично записанные кэш-линии. Поэтому сначала копим
+    // элементы каждой корзины в маленьком буфере (он всегда в L1), и только
+    // когда он заполнится, сбрасываем его в to целиком одним блоком.
+    const size_t stageSize = staging.size() / RADIX;
+    std::array<size_t, RADIX> filled{};
+
+    for (const T& item : from) {
+        size_t d = radixDigit(key(item), shift);
+        T* stage = staging.data() + d * stageSize;
+        stage[filled[d]++] = item;
+
+        if (filled[d] == stageSize) {
+            std::copy_n(stage, stageSize, to.data() + offsets[d]);
+            offsets[d] += stageSize;
+            filled[d] = 0;
+        }
+    }
+
+    // Сбрасываем то, что осталось в буферах.
+    for (size_t d = 0; d < RADIX; d++) {
+        std::copy_n(staging.data() + d * stageSize, filled[d], to.data() + offsets[d]);
+    }
+}
+
+// Выделяем буферы write-combining для прохода по n элементам. Буферизация
+// возможна только для тривиально копируемых типов и нужна только на больших массивах.
+template<class T>
+std::vector<T> radixStaging(size_t n) {
+    std::vector<T> staging;
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if (n >= RADIX_STAGING_THRESHOLD) {
+            staging.resize(RADIX * std::max<size_t>(1, RADIX_STAGING_BYTES / sizeof(T)));
+        }
+    }
+    return staging;
+}
+
+// Поразрядная сортировка по ключу, который возвращает key (беззнаковое целое).
+// Элементы перекладываются между arr и buffer (того же размера) "пинг-понгом":
+// на чётных проходах из arr в buffer, на нечётных обратно, так что никаких
+// векторов-корзин, которые растут через push_back, больше нет.
+template<class T, class KeyFn>
+requires std::unsigned_integral<std::invoke_result_t<KeyFn, const T&>>
+void radixSortByKey(std::span<T> arr, std::span<T> buffer, KeyFn key) {
+    using K = std::invoke_result_t<KeyFn, const T&>;
+
+    if (arr.size() <= 1) {
+        return;
+    }
+
+    auto counts = radixHistograms<T>(arr, key);
+    auto staging = radixStaging<T>(arr.size());
+
+    std::span<T> from = arr;
+    std::span<T> to = buffer;
+
+    for (size_t pass = 0; pass < sizeof(K); pass++) {
+        // Если у всех ключей в этом байте одна и та же цифра, то проход
+        // ничего не поменяет -- пропускаем его. Так, например, для чисел
+        // меньше 2^16 выполнятся только два прохода из четырёх.
+        if (counts[pass][radixDigit(key(from[0]), pass * RADIX_BITS)] == arr.size()) {
+            continue;
+        }
+
+        radixScatter(from, to, radixOffsets(counts[pass]), pass * RADIX_BITS, key, std::span<T>(staging));
+        std::swap(from, to);
+    }
+
+    // Если после последнего прохода результат оказался в buffer, возвращаем его в arr.
+    if (from.data() != arr.data()) {
+        std::move(from.begin(), from.end(), arr.begin());
+    }
+}
+
+// Сколько элементов должно приходиться на один поток, чтобы его запуск
+// и синхронизация окупались.
+constexpr size_t RADIX_PARALLEL_GRAIN = size_t{1} << 16;
+
+// Многопоточная версия radixSortByKey. Массив делится на threadCount равных
+// кусков, и на каждом проходе:
+//   1. каждый поток считает гистограмму цифр своего куска;
+//   2. по гистограммам всех потоков каждый поток вычисляет, куда писать: элемент
+//      с цифрой d из куска t попадает после всех элементов с меньшими цифрами и
+//      после элементов с цифрой d из кусков 0..t-1 (префиксная сумма по цифрам
+//      и по потокам), поэтому области записи потоков не пересекаются;
+//   3. каждый поток раскладывает свой кусок -- без блокировок, а порядок
+//      элементов с одинаковой цифрой сохраняется, как и в однопоточной версии.
+// Между этапами потоки ждут друг друга на барьере.
+template<class T, class KeyFn>
+requires std::unsigned_integral<std::invoke_result_t<KeyFn, const T&>>
+void radixSortByKeyParallel(std::span<T> arr, std::span<T> buffer, KeyFn key, size_t threadCount) {
+    using K = std::invoke_result_t<KeyFn, const T&>;
+
+    const size_t n = arr.size();
+    threadCount = std::clamp<size_t>(n / RADIX_PARALLEL_GRAIN, 1, std::max<size_t>(threadCount, 1));
+    if (threadCount == 1) {
+        radixSortByKey(arr, buffer, key);
+        return;
+    }
+
+    // Гистограммы всех проходов для куска каждого потока. Из их суммы мы узнаём,
+    // какие проходы можно пропустить, а для первого прохода они же служат
+    // гистограммами кусков (дальше элементы перемешиваются, и считать придётся заново).
+    std::vector<RadixHistograms<K>> initial(threadCount);
+
+    // Гистограмма текущего прохода для куска каждого потока.
+    std::vector<std::array<size_t, RADIX>> counts(threadCount);
+
+    std::barrier sync(static_cast<std::ptrdiff_t>(threadCount));
+
+    auto worker = [&](size_t t) {
+        const size_t begin = t * n / threadCount;
+        const size_t end = (t + 1) * n / threadCount;
+
+        initial[t] = radixHistograms<T>(arr.subspan(begin, end - begin), key);
+        sync.arrive_and_wait();
+
+        // Каждый поток сам (и одинаково с остальными) решает, какие проходы нужны.
+        std::vector<size_t> passes;
+        for (size_t pass = 0; pass < sizeof(K); pass++) {
+            size_t digit = radixDigit(key(arr[0]), pass * RADIX_BITS);
+            size_t same = 0;
+            for (size_t u = 0; u < threadCount; u++) {
+                same += initial[u][pass][digit];
+            }
+            if (same != n) {
+                passes.push_back(pass);
+            }
+        }
+
+        auto staging = radixStaging<T>(end - begin);
+        std::span<T> from = arr;
+        std::span<T> to = buffer;
+
+        for (size_t i = 0; i < passes.size(); i++) {
+            const size_t shift = passes[i] * RADIX_BITS;
+            std::span<T> slice = from.subspan(begin, end - begin);
+
+            if (i == 0) {
+                counts[t] = initial[t][passes[i]];
+            } else {
+                counts[t].fill(0);
+                for (const T& item : slice) {
+                    counts[t][radixDigit(key(item), shift)]++;
+                }
+            }
+            sync.arrive_and_wait();
+
+            std::array<size_t, RADIX> offsets;
+            size_t sum = 0;
+            for (size_t d = 0; d < RADIX; d++) {
+                for (size_t u = 0; u < threadCount; u++) {
+                    if (u == t) {
+                        offsets[d] = sum;
+                    }
+                    sum += counts[u][d];
+                }
+            }
+
+            radixScatter(slice, to, offsets, shift, key, std::span<T>(staging));
+
+            // Следующий проход читает то, что записали все потоки,
+            // и перезаписывает counts -- ждём, пока все закончат.
+            sync.arrive_and_wait();
+            std::swap(from, to);
+        }
+
+        // Если результат оказался в buffer, каждый поток возвращает в arr свой кусок.
+        if (from.data() != arr.data()) {
+            std::move(from.begin() + begin, from.begin() + end, arr.begin() + begin);
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(threadCount - 1);
+    for (size_t t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+}
+
+// Сортировка массива любого из поддерживаемых типов.
+template<RadixSortable T>
+void radixLSDSort(std::span<T> arr) {
+    std::vector<T> buffer(arr.size());
+    radixSortByKey(arr, std::span<T>(buffer), [](T value) { return radixKey(value); });
+}
+
+template<RadixSortable T>
+void radixLSDSort(std::vector<T>& arr) {
+    radixLSDSort(std::span<T>(arr));
+}
+
+// Многопоточная сортировка массива любого из поддерживаемых типов.
+template<RadixSortable T>
+void radixLSDSortParallel(std::span<T> arr, size_t threadCount = std::thread::hardware_concurrency()) {
+    std::vector<T> buffer(arr.size());
+    radixSortByKeyParallel(arr, std::span<T>(buffer), [](T value) { return radixKey(value); }, threadCount);
+}
+
+// Устойчивая сортировка записей по ключу: key возвращает для записи значение
+// любого поддерживаемого типа (это может быть и указатель на поле, например
+// radixSortBy(edges, &Edge::source)). Записи с равными ключами сохраняют
+// исходный порядок, поэтому можно сортировать по нескольким полям, начиная
+// с младшего, -- без упаковки ключей в одно число и без сортировки слиянием.
+template<class T, class KeyFn>
+requires RadixSortable<std::remove_cvref_t<std::invoke_result_t<KeyFn, const T&>>>
+void radixSortBy(std::span<T> arr, KeyFn key) {
+    std::vector<T> buffer(arr.size());
+    radixSortByKey(arr, std::span<T>(buffer), [&key](const T& item) {
+        return radixKey(std::invoke(key, item));
+    });
+}
+
+// Ключ вместе с исходной позицией элемента. Ключ хранится уже преобразованным,
+// чтобы не вычислять radixKey заново на каждом проходе.
+template<RadixSortable K>
+struct RadixIndexedKey {
+    RadixKey<K> key;
+    size_t index;
+};
+
+// Сортировка "аргументов": возвращает перестановку order, такую что
+// keys[order[0]] <= keys[order[1]] <= ... Равные ключи идут в порядке индексов.
+// Сам массив keys не меняется.
+template<RadixSortable K>
+std::vector<size_t> radixArgsort(std::span<const K> keys) {
+    std::vector<RadixIndexedKey<K>> items(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        items[i] = {radixKey(keys[i]), i};
+    }
+
+    std::vector<RadixIndexedKey<K>> buffer(keys.size());
+    radixSortByKey(
+        std::span<RadixIndexedKey<K>>(items),
+        std::span<RadixIndexedKey<K>>(buffer),
+        [](const RadixIndexedKey<K>& item) { return item.key; }
+    );
+
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        order[i] = items[i].index;
+    }
+    return order;
+}
+
+// Устойчивая сортировка "структуры массивов": keys и values -- параллельные
+// массивы одной длины, values переставляются вслед за keys.
+template<RadixSortable K, class V>
+void radixSortPairs(std::span<K> keys, std::span<V> values) {
+    if (keys.size() != values.size()) {
+        throw std::invalid_argument("radixSortPairs: keys and values must have the same size");
+    }
+
+    auto order = radixArgsort(std::span<const K>(keys));
+
+    std::vector<K> sortedKeys;
+    sortedKeys.reserve(keys.size());
+    std::vector<V> sortedValues;
+    sortedValues.reserve(values.size());
+
+    for (size_t index : order) {
+        sortedKeys.push_back(keys[index]);
+        sortedValues.push_back(std::move(values[index]));
+    }
+
+    std::copy(sortedKeys.begin(), sortedKeys.end(), keys.begin());
+    std::move(sortedValues.begin(), sortedValues.end(), values.begin());
+}
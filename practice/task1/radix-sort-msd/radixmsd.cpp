@@ -0,0 +1,93 @@
+#include "../../common/binary-array.hpp"
+#include "../../common/fast-io.hpp"
+#include "radixmsd.hpp"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+// Считываем, сортируем и выводим массив элементов типа T.
+// Если timings_mode включён, в stderr выводится время разбора ввода, сортировки и вывода.
+template<RadixSortable T>
+int run(bool benchmark_mode, bool timings_mode) {
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
+
+    // считываем массив
+    std::vector<T> arr;
+    try {
+        timings.parse = measureMicroseconds([&]() { arr = input.template readArray<T>(); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // сортируем массив
+    timings.sort = measureMicroseconds([&]() { radixMSDSort(std::span<T>(arr)); });
+
+    if (benchmark_mode) {
+        output.write(timings.sort);
+        output.write('\n');
+    } else {
+        // выводим массив на экран
+        timings.write = measureMicroseconds([&]() {
+            output.writeArray(std::span<const T>(arr));
+            output.flush();
+        });
+    }
+
+    if (timings_mode) {
+        timings.report();
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    bool benchmark_mode = false;
+    bool timings_mode = false;
+
+    // --binary FILE сортирует двоичный файл на месте вместо текстового ввода
+    // (тип элементов тогда берётся из заголовка файла, а не из --type)
+    std::string binary_path;
+
+    // тип элементов можно указать флагом --type, по умолчанию это int
+    std::string type = "i32";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--benchmark") {
+            benchmark_mode = true;
+        } else if (arg == "--timings") {
+            timings_mode = true;
+        } else if (arg == "--type" && i + 1 < argc) {
+            type = argv[++i];
+        } else if (arg == "--binary" && i + 1 < argc) {
+            binary_path = argv[++i];
+        }
+    }
+
+    if (!binary_path.empty()) {
+        return sortBinaryFile(binary_path, benchmark_mode, timings_mode, [](auto arr) { radixMSDSort(arr); });
+    }
+
+    if (type == "i32") {
+        return run<int32_t>(benchmark_mode, timings_mode);
+    } else if (type == "i64") {
+        return run<int64_t>(benchmark_mode, timings_mode);
+    } else if (type == "u32") {
+        return run<uint32_t>(benchmark_mode, timings_mode);
+    } else if (type == "u64") {
+        return run<uint64_t>(benchmark_mode, timings_mode);
+    } else if (type == "f32") {
+        return run<float>(benchmark_mode, timings_mode);
+    } else if (type == "f64") {
+        return run<double>(benchmark_mode, timings_mode);
+    } else {
+        std::cerr << "Неизвестный тип: " << type << std::endl;
+        return 1;
+    }
+}
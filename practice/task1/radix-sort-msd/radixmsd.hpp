@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../radix-sort-lsd/radixlsd.hpp"
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// Корзины размером не больше этого досортировываются вставками: на паре
+// десятков элементов подсчёт 256 счётчиков стоит дороже самой сортировки.
+constexpr size_t MSD_INSERTION_THRESHOLD = 32;
+
+// Сортировка вставками по ключу, ей досортировываются маленькие корзины.
+template<class T, class KeyFn>
+void insertionSortByKey(std::span<T> arr, KeyFn key) {
+    for (size_t i = 1; i < arr.size(); i++) {
+        T value = std::move(arr[i]);
+        auto valueKey = key(value);
+
+        size_t j = i;
+        while (j > 0 && valueKey < key(arr[j - 1])) {
+            arr[j] = std::move(arr[j - 1]);
+            j--;
+        }
+        arr[j] = std::move(value);
+    }
+}
+
+// Поразрядная сортировка от старшего разряда "на месте" (American flag sort).
+// В отличие от LSD-версии, здесь нет ни корзин-векторов, ни буфера размера n:
+//   1. считаем, сколько элементов попадёт в каждую из 256 корзин по текущему байту;
+//   2. по префиксным суммам знаем, где начинается и кончается каждая корзина;
+//   3. переставляем элементы циклами: берём элемент, который стоит не в своей
+//      корзине, и меняем его с элементом в начале его корзины, пока на место
+//      не встанет элемент нужной корзины;
+//   4. рекурсивно сортируем каждую корзину по следующему байту.
+// Рекурсия не глубже количества байт в ключе, а на каждом уровне нужно лишь
+// O(radix) памяти под счётчики, поэтому пиковая дополнительная память -- O(radix),
+// а не O(n). Платой за это является неустойчивость сортировки.
+template<class T, class KeyFn>
+requires std::unsigned_integral<std::invoke_result_t<KeyFn, const T&>>
+void radixMSDSortByKey(std::span<T> arr, KeyFn key, size_t shift) {
+    // Пока все элементы попадают в одну корзину, переходим к следующему
+    // байту без рекурсии (это частый случай для маленьких чисел в широком типе).
+    while (true) {
+        if (arr.size() <= MSD_INSERTION_THRESHOLD) {
+            insertionSortByKey(arr, key);
+            return;
+        }
+
+        std::array<size_t, RADIX> counts{};
+        for (const T& item : arr) {
+            counts[radixDigit(key(item), shift)]++;
+        }
+
+        if (counts[radixDigit(key(arr[0]), shift)] == arr.size()) {
+            if (shift == 0) {
+                return;
+            }
+            shift -= RADIX_BITS;
+            continue;
+        }
+
+        // heads[d] -- первая позиция корзины d, на которой ещё стоит "чужой"
+        // элемент, tails[d] -- конец корзины d.
+        std::array<size_t, RADIX> heads = radixOffsets(counts);
+        std::array<size_t, RADIX> tails;
+        for (size_t d = 0; d < RADIX; d++) {
+            tails[d] = heads[d] + counts[d];
+        }
+
+        for (size_t d = 0; d < RADIX; d++) {
+            while (heads[d] < tails[d]) {
+                T value = std::move(arr[heads[d]]);
+                size_t valueDigit = radixDigit(key(value), shift);
+
+                // Перекладываем value в начало её корзины, а вытесненный оттуда
+                // элемент становится новым value. Цикл замкнётся, когда вытесненный
+                // элемент окажется из корзины d.
+                while (valueDigit != d) {
+                    std::swap(value, arr[heads[valueDigit]++]);
+                    valueDigit = radixDigit(key(value), shift);
+                }
+                arr[heads[d]++] = std::move(value);
+            }
+        }
+
+        if (shift == 0) {
+            return;
+        }
+
+        // Корзины уже расставлены, каждую сортируем по следующему байту.
+        size_t begin = 0;
+        for (size_t d = 0; d < RADIX; d++) {
+            if (counts[d] > 1) {
+                radixMSDSortByKey(arr.subspan(begin, counts[d]), key, shift - RADIX_BITS);
+            }
+            begin += counts[d];
+        }
+        return;
+    }
+}
+
+// Перегрузка, которая начинает со старшего байта ключа.
+template<class T, class KeyFn>
+requires std::unsigned_integral<std::invoke_result_t<KeyFn, const T&>>
+void radixMSDSortByKey(std::span<T> arr, KeyFn key) {
+    using K = std::invoke_result_t<KeyFn, const T&>;
+    radixMSDSortByKey(arr, key, (sizeof(K) - 1) * RADIX_BITS);
+}
+
+// Сортировка массива любого из поддерживаемых типов на месте.
+template<RadixSortable T>
+void radixMSDSort(std::span<T> arr) {
+    radixMSDSortByKey(arr, [](T value) { return radixKey(value); });
+}
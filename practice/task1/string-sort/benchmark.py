@@ -0,0 +1,64 @@
+import random
+import statistics
+import subprocess
+import sys
+
+# Сравнение сортировок строк на нескольких наборах данных, в том числе с
+# длинными общими префиксами (URL, ключи логов), на которых сортировки
+# сравнением тратят время на повторный проход общих префиксов.
+#
+# Запуск: python3 benchmark.py [n], программа должна быть собрана (just compile).
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 200000
+repeats = 5
+
+
+def random_word():
+    return "".join(random.choices("abcdefghijklmnopqrstuvwxyz", k=random.randint(4, 16)))
+
+
+def url():
+    return "https://example.com/api/v1/users/{}/orders/{}/items?page={}".format(
+        random.randint(0, 999), random.randint(0, 99999), random.randint(0, 9))
+
+
+def log_key():
+    return "service=billing/host=node-{:03d}/2024-05-{:02d}T{:02d}:{:02d}:{:02d}.{:06d}".format(
+        random.randint(0, 15), random.randint(1, 31), random.randint(0, 23),
+        random.randint(0, 59), random.randint(0, 59), random.randint(0, 999999))
+
+
+def duplicate():
+    return "/var/log/app/{}.log".format(random.randint(0, 99))
+
+
+corpora = {
+    "random": random_word,
+    "urls": url,
+    "log keys": log_key,
+    "duplicates": duplicate,
+}
+modes = ["compare", "multikey", "msd"]
+
+print(f"n = {n}, время в мкс (медиана из {repeats})")
+print(f"{'набор':<12} {'тип':<8}" + "".join(f"{mode:>12}" for mode in modes))
+
+for corpus_name, generate in corpora.items():
+    input_data = (f"{n} " + " ".join(generate() for _ in range(n))).encode()
+
+    for string_type in ["string", "view"]:
+        row = f"{corpus_name:<12} {string_type:<8}"
+        for mode in modes:
+            times = []
+            for _ in range(repeats):
+                proc = subprocess.run(
+                    ["./a.out", "--benchmark", "--mode", mode, "--type", string_type],
+                    input=input_data,
+                    capture_output=True,
+                )
+                if proc.returncode != 0:
+                    print(f"\nОшибка выполнения: {proc.stderr.decode()}")
+                    exit(1)
+                times.append(int(proc.stdout.decode().strip()))
+            row += f"{statistics.median(times):>12}"
+        print(row)
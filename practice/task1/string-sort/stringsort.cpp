@@ -0,0 +1,99 @@
+#include "../../common/fast-io.hpp"
+#include "stringsort.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Считываем, сортируем и выводим массив строк типа S.
+// Если timings_mode включён, в stderr выводится время разбора ввода, сортировки и вывода.
+template<StringLike S>
+int run(const std::string& mode, bool benchmark_mode, bool timings_mode) {
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
+
+    // считываем массив
+    std::vector<S> arr;
+    try {
+        timings.parse = measureMicroseconds([&]() { arr = input.template readArray<S>(); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // сортируем массив
+    timings.sort = measureMicroseconds([&]() {
+        if (mode == "multikey") {
+            multikeyQuicksort(std::span<S>(arr));
+        } else if (mode == "compare") {
+            std::sort(arr.begin(), arr.end());
+        } else {
+            radixMSDStringSort(std::span<S>(arr));
+        }
+    });
+
+    if (benchmark_mode) {
+        output.write(timings.sort);
+        output.write('\n');
+    } else {
+        // выводим массив на экран
+        timings.write = measureMicroseconds([&]() {
+            output.writeArray(std::span<const S>(arr));
+            output.flush();
+        });
+    }
+
+    if (timings_mode) {
+        timings.report();
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    bool benchmark_mode = false;
+
+    // --timings выводит в stderr время разбора ввода, сортировки и вывода
+    bool timings_mode = false;
+
+    // --mode выбирает вариант сортировки:
+    // msd -- поразрядная сортировка от старшего разряда с кэшем символов (по умолчанию),
+    // multikey -- трёхчастная поразрядная быстрая сортировка,
+    // compare -- std::sort сравнением строк (для сравнения)
+    std::string mode = "msd";
+
+    // --type string сортирует std::string (по умолчанию), --type view --
+    // std::string_view, ссылающиеся прямо на буфер ввода
+    std::string type = "string";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--benchmark") {
+            benchmark_mode = true;
+        } else if (arg == "--timings") {
+            timings_mode = true;
+        } else if (arg == "--mode" && i + 1 < argc) {
+            mode = argv[++i];
+        } else if (arg == "--type" && i + 1 < argc) {
+            type = argv[++i];
+        }
+    }
+
+    if (mode != "msd" && mode != "multikey" && mode != "compare") {
+        std::cerr << "Неизвестный вариант сортировки: " << mode << std::endl;
+        return 1;
+    }
+
+    if (type == "string") {
+        return run<std::string>(mode, benchmark_mode, timings_mode);
+    } else if (type == "view") {
+        return run<std::string_view>(mode, benchmark_mode, timings_mode);
+    } else {
+        std::cerr << "Неизвестный тип: " << type << std::endl;
+        return 1;
+    }
+}
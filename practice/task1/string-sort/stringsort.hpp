@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Сортировки строк (std::string, std::string_view).
+//
+// Обычные сортировки сравнением работают и на строках, но каждое сравнение
+// a < b заново проходит общий префикс a и b с начала. На URL и ключах логов
+// с длинными общими префиксами почти всё время уходит именно на это. Здесь
+// строки сортируются по символам, как числа в поразрядной сортировке: группа
+// строк с общим префиксом длины depth разбивается по символу на позиции depth,
+// и каждый символ каждой строки просматривается O(1) раз на уровень.
+
+// Корзины размером не больше этого досортировываются вставками.
+constexpr size_t STRING_INSERTION_THRESHOLD = 16;
+
+// Группы размером не больше этого поразрядная сортировка отдаёт трёхчастной
+// быстрой сортировке: на них 257 счётчиков стоят дороже самой сортировки.
+constexpr size_t STRING_RADIX_THRESHOLD = 64;
+
+// Символ строки с номером 0 -- это конец строки, остальные байты сдвинуты на 1,
+// чтобы короткая строка шла раньше своих продолжений, даже если в строках
+// встречается '\0'.
+constexpr size_t STRING_ALPHABET = 257;
+
+template<class S>
+concept StringLike = std::convertible_to<const S&, std::string_view>;
+
+// Символ s на позиции depth (см. STRING_ALPHABET).
+template<StringLike S>
+uint16_t stringCharAt(const S& s, size_t depth) {
+    std::string_view view = s;
+    return depth < view.size() ? static_cast<unsigned char>(view[depth]) + 1 : 0;
+}
+
+// Сортировка вставками строк с общим префиксом длины depth: сравниваем только
+// то, что идёт после префикса.
+template<StringLike S>
+void stringInsertionSort(std::span<S> arr, size_t depth) {
+    for (size_t i = 1; i < arr.size(); i++) {
+        S value = std::move(arr[i]);
+        std::string_view valueSuffix = std::string_view(value).substr(depth);
+
+        size_t j = i;
+        while (j > 0 && valueSuffix < std::string_view(arr[j - 1]).substr(depth)) {
+            arr[j] = std::move(arr[j - 1]);
+            j--;
+        }
+        arr[j] = std::move(value);
+    }
+}
+
+// Трёхчастная поразрядная быстрая сортировка (multikey quicksort, Бентли и
+// Седжвик). Разбиваем группу по символу на позиции depth относительно
+// опорного символа на три части: меньше, равно и больше. В части "равно" у
+// всех строк общий префикс стал длиннее на символ, и её сортируем со
+// следующей позиции, а две другие -- с той же.
+// Рекурсивно сортируем две меньшие части, а к самой большой переходим в
+// цикле, поэтому глубина рекурсии -- O(log n), даже если строки длинные.
+template<StringLike S>
+void multikeyQuicksort(std::span<S> arr, size_t depth) {
+    while (arr.size() > STRING_INSERTION_THRESHOLD) {
+        // опорный символ -- медиана первого, среднего и последнего
+        uint16_t a = stringCharAt(arr[0], depth);
+        uint16_t b = stringCharAt(arr[arr.size() / 2], depth);
+        uint16_t c = stringCharAt(arr[arr.size() - 1], depth);
+        uint16_t pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+        // [0, lt) -- меньше опорного, [lt, i) -- равны, [gt, n) -- больше
+        size_t lt = 0;
+        size_t i = 0;
+        size_t gt = arr.size();
+        while (i < gt) {
+            uint16_t ch = stringCharAt(arr[i], depth);
+            if (ch < pivot) {
+                std::swap(arr[lt++], arr[i++]);
+            } else if (ch > pivot) {
+                std::swap(arr[i], arr[--gt]);
+            } else {
+                i++;
+            }
+        }
+
+        struct Part {
+            std::span<S> arr;
+            size_t depth;
+        };
+        std::array<Part, 3> parts = {{
+            {arr.first(lt), depth},
+            {arr.subspan(lt, gt - lt), depth + 1},
+            {arr.subspan(gt), depth},
+        }};
+
+        // Если опорный символ -- конец строки, в части "равно" одинаковые строки.
+        if (pivot == 0) {
+            parts[1].arr = {};
+        }
+
+        size_t largest = 0;
+        for (size_t k = 1; k < parts.size(); k++) {
+            if (parts[k].arr.size() > parts[largest].arr.size()) {
+                largest = k;
+            }
+        }
+        for (size_t k = 0; k < parts.size(); k++) {
+            if (k != largest && parts[k].arr.size() > 1) {
+                multikeyQuicksort(parts[k].arr, parts[k].depth);
+            }
+        }
+        arr = parts[largest].arr;
+        depth = parts[largest].depth;
+    }
+
+    stringInsertionSort(arr, depth);
+}
+
+template<StringLike S>
+void multikeyQuicksort(std::span<S> arr) {
+    multikeyQuicksort(arr, 0);
+}
+
+template<StringLike S>
+void multikeyQuicksort(std::vector<S>& arr) {
+    multikeyQuicksort(std::span<S>(arr));
+}
+
+// Поразрядная сортировка строк от старшего разряда "на месте" с кэшем символов
+// (American flag sort, см. radixMSDSortByKey).
+// Символ строки на текущей позиции достаётся один раз за проход и кладётся в
+// cache[i] рядом с остальными: дальше подсчёт корзин и перестановка циклами
+// читают последовательный массив из 2-байтовых чисел, а не ходят по указателю
+// в каждую строку (для std::string -- ещё и мимо буфера короткой строки).
+// При перестановке cache переставляется вместе со строками.
+// Строки из корзины 0 закончились и равны друг другу, остальные корзины
+// сортируем со следующей позиции: самую большую -- в цикле, остальные
+// рекурсивно, так что глубина рекурсии -- O(log n).
+template<StringLike S>
+void radixMSDStringSort(std::span<S> arr, std::span<uint16_t> cache, size_t depth) {
+    while (arr.size() > STRING_RADIX_THRESHOLD) {
+        std::array<size_t, STRING_ALPHABET> counts{};
+        for (size_t i = 0; i < arr.size(); i++) {
+            cache[i] = stringCharAt(arr[i], depth);
+            counts[cache[i]]++;
+        }
+
+        // Пока у всех строк один и тот же символ (длинный общий префикс),
+        // просто переходим к следующей позиции.
+        if (counts[cache[0]] == arr.size()) {
+            if (cache[0] == 0) {
+                return;
+            }
+            depth++;
+            continue;
+        }
+
+        std::array<size_t, STRING_ALPHABET> heads;
+        std::array<size_t, STRING_ALPHABET> tails;
+        size_t offset = 0;
+        for (size_t d = 0; d < STRING_ALPHABET; d++) {
+            heads[d] = offset;
+            offset += counts[d];
+            tails[d] = offset;
+        }
+
+        for (size_t d = 0; d < STRING_ALPHABET; d++) {
+            while (heads[d] < tails[d]) {
+                S value = std::move(arr[heads[d]]);
+                uint16_t valueChar = cache[heads[d]];
+
+                while (valueChar != d) {
+                    size_t target = heads[valueChar]++;
+                    std::swap(value, arr[target]);
+                    std::swap(valueChar, cache[target]);
+                }
+                cache[heads[d]] = valueChar;
+                arr[heads[d]++] = std::move(value);
+            }
+        }
+
+        size_t largest = 1;
+        for (size_t d = 2; d < STRING_ALPHABET; d++) {
+            if (counts[d] > counts[largest]) {
+                largest = d;
+            }
+        }
+
+        size_t begin = counts[0];
+        std::span<S> largestBucket;
+        std::span<uint16_t> largestCache;
+        for (size_t d = 1; d < STRING_ALPHABET; d++) {
+            if (d == largest) {
+                largestBucket = arr.subspan(begin, counts[d]);
+                largestCache = cache.subspan(begin, counts[d]);
+            } else if (counts[d] > 1) {
+                radixMSDStringSort(arr.subspan(begin, counts[d]), cache.subspan(begin, counts[d]), depth + 1);
+            }
+            begin += counts[d];
+        }
+
+        arr = largestBucket;
+        cache = largestCache;
+        depth++;
+    }
+
+    multikeyQuicksort(arr, depth);
+}
+
+template<StringLike S>
+void radixMSDStringSort(std::span<S> arr) {
+    std::vector<uint16_t> cache(arr.size());
+    radixMSDStringSort(arr, std::span<uint16_t>(cache), 0);
+}
+
+template<StringLike S>
+void radixMSDStringSort(std::vector<S>& arr) {
+    radixMSDStringSort(std::span<S>(arr));
+}
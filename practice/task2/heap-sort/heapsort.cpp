@@ -1,104 +1,119 @@
-#include <utility>
-#include <vector>
+#include "../../common/binary-array.hpp"
+#include "../../common/fast-io.hpp"
+#include "../../common/indirect-sort.hpp"
+#include "heapsort.hpp"
+
+#include <exception>
 #include <iostream>
 #include <span>
-#include <chrono>
+#include <string>
+#include <vector>
 
-// Эта функция "просеивает" узел дерева до тех пор, пока оно не нарушит свойство кучи.
-template<class T>
-requires requires (const T& a, const T& b) {
-   { a < b } -> std::convertible_to<bool>;
-   { a > b } -> std::convertible_to<bool>;
-}
-void siftDown(std::span<T> arr, int nodeIdx) {
-    // Выполняем цикл до тех пор, пока у нас есть дочерние узлы
-    while (2 * nodeIdx + 1 < arr.size()) {
-        // Изначально выбираем левого потомка
-        int childIdx = 2 * nodeIdx + 1;
-
-        // Если правый потомок существует и больше левого, выбираем его
-        if (childIdx + 1 < arr.size() && arr[childIdx + 1] > arr[childIdx]) {
-            childIdx++;
+int main(int argc, char* argv[]) {
+    bool benchmark_mode = false;
+
+    // --timings выводит в stderr время разбора ввода, сортировки и вывода
+    bool timings_mode = false;
+
+    // --binary FILE сортирует двоичный файл на месте вместо текстового ввода
+    std::string binary_path;
+
+    // --indirect сортирует косвенно: выбранный вариант упорядочивает компактные
+    // записи "префикс ключа + указатель на элемент", а сами элементы затем
+    // переставляются на свои места по одному разу (для тяжёлых элементов)
+    bool indirect_mode = false;
+
+    // --mode выбирает вариант сортировки:
+    // dary -- на d-арной куче с просеиванием по Флойду (по умолчанию),
+    // classic -- на простой двоичной куче;
+    // --arity 2|4|8 задаёт арность d-арной кучи
+    std::string mode = "dary";
+    size_t arity = HEAPSORT_ARITY;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--benchmark") {
+                benchmark_mode = true;
+            } else if (arg == "--timings") {
+                timings_mode = true;
+            } else if (arg == "--indirect") {
+                indirect_mode = true;
+            } else if (arg == "--binary" && i + 1 < argc) {
+                binary_path = argv[++i];
+            } else if (arg == "--mode" && i + 1 < argc) {
+                mode = argv[++i];
+            } else if (arg == "--arity" && i + 1 < argc) {
+                arity = parseFlagValue(arg, argv[++i]);
+            }
         }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 
-        // Если потомок больше родителя, меняем их местами и продолжаем просеивание
-        if (arr[childIdx] > arr[nodeIdx]) {
-            std::swap(arr[childIdx], arr[nodeIdx]);
-            nodeIdx = childIdx;
+    // сортировка выбранным вариантом
+    auto sortDirect = [&mode, arity](auto arr) {
+        if (mode == "classic") {
+            heapsortClassic(arr);
+        } else if (arity == 2) {
+            heapsortDary<2>(arr);
+        } else if (arity == 8) {
+            heapsortDary<8>(arr);
         } else {
-            // Если потомок меньше или равен родителю, то просеивание завершено
-            break;
+            heapsortDary<4>(arr);
         }
-    }
-}
+    };
 
-// Преобразовываем обычный массив в кучу
-template<class T>
-requires requires (const T& a, const T& b) {
-   { a < b } -> std::convertible_to<bool>;
-   { a > b } -> std::convertible_to<bool>;
-}
-void heapify(std::span<T> arr) {
-    for (int i = arr.size(); i >= 0; i--) {
-        siftDown(arr, i);
-    }
-}
+    auto sort = [&sortDirect, indirect_mode](auto arr) {
+        if (indirect_mode) {
+            sortIndirect(arr, sortDirect);
+        } else {
+            sortDirect(arr);
+        }
+    };
 
-// Пирамидальная сортировка
-template<class T>
-requires requires (const T& a, const T& b) {
-   { a < b } -> std::convertible_to<bool>;
-   { a > b } -> std::convertible_to<bool>;
-}
-void heapsort(std::vector<T>& arr) {
-    std::span<T> arrSpan(arr);
-
-    // Сначала мы преобразуем массив в кучу
-    heapify(arrSpan);
-
-    // Потом мы каждый раз будем доставать минимальный элемент кучи и ставить его в конец
-    // При этом элемент, который стал первым, мы просеиваем вниз
-    for (int i = 0; i < arr.size() - 1; i++) {
-        std::swap(arr[0], arr[arrSpan.size() - 1]);
-        arrSpan = arrSpan.first(arrSpan.size() - 1);
-        siftDown(arrSpan, 0);
+    if (mode != "classic" && mode != "dary") {
+        std::cerr << "Неизвестный вариант сортировки: " << mode << std::endl;
+        return 1;
+    }
+    if (arity != 2 && arity != 4 && arity != 8) {
+        std::cerr << "Арность кучи должна быть 2, 4 или 8: " << arity << std::endl;
+        return 1;
     }
-}
 
-int main(int argc, char* argv[]) {
-    bool benchmark_mode = false;
-    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
-        benchmark_mode = true;
+    if (!binary_path.empty()) {
+        return sortBinaryFile(binary_path, benchmark_mode, timings_mode, sort);
     }
 
-    int n;  // кол-во элементов
-    std::cin >> n;
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
 
-    // указываем capacity = n, тем самым сразу аллоцировав место под n элеметов
+    // считываем массив
     std::vector<int> arr;
-    arr.reserve(n);
-
-    // заполняем массив
-    for (int i = 0; i < n; i++) {
-        int num;
-        std::cin >> num;
-        arr.push_back(num);
+    try {
+        timings.parse = measureMicroseconds([&]() { arr = input.readArray<int>(); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
     // сортируем массив
+    timings.sort = measureMicroseconds([&]() { sort(std::span<int>(arr)); });
+
     if (benchmark_mode) {
-        auto start = std::chrono::high_resolution_clock::now();
-        heapsort(arr);
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        std::cout << duration.count() << std::endl;
+        output.write(timings.sort);
+        output.write('\n');
     } else {
-        heapsort(arr);
-
         // выводим массив на экран
-        for (int num : arr) {
-            std::cout << num << " ";
-        }
-        std::cout << std::endl;
+        timings.write = measureMicroseconds([&]() {
+            output.writeArray(std::span<const int>(arr));
+            output.flush();
+        });
+    }
+
+    if (timings_mode) {
+        timings.report();
     }
 }
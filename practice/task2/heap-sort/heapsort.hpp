@@ -0,0 +1,282 @@
+#pragma once
+
+#include "../../common/insertion-sort.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Эта функция "просеивает" узел дерева до тех пор, пока оно не нарушит свойство кучи.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void siftDown(std::span<T> arr, size_t nodeIdx) {
+    // Выполняем цикл до тех пор, пока у нас есть дочерние узлы
+    while (2 * nodeIdx + 1 < arr.size()) {
+        // Изначально выбираем левого потомка
+        size_t childIdx = 2 * nodeIdx + 1;
+
+        // Если правый потомок существует и больше левого, выбираем его
+        if (childIdx + 1 < arr.size() && arr[childIdx + 1] > arr[childIdx]) {
+            childIdx++;
+        }
+
+        // Если потомок больше родителя, меняем их местами и продолжаем просеивание
+        if (arr[childIdx] > arr[nodeIdx]) {
+            std::swap(arr[childIdx], arr[nodeIdx]);
+            nodeIdx = childIdx;
+        } else {
+            // Если потомок меньше или равен родителю, то просеивание завершено
+            break;
+        }
+    }
+}
+
+// Преобразовываем обычный массив в кучу
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void heapify(std::span<T> arr) {
+    // Просеиваем все узлы, у которых есть потомки, начиная с последнего
+    for (size_t i = arr.size() / 2; i-- > 0;) {
+        siftDown(arr, i);
+    }
+}
+
+// Пирамидальная сортировка на простой двоичной куче (с функциями выше).
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void heapsortClassic(std::span<T> arr) {
+    std::span<T> arrSpan(arr);
+
+    // Сначала мы преобразуем массив в кучу
+    heapify(arrSpan);
+
+    // Потом мы каждый раз будем доставать минимальный элемент кучи и ставить его в конец
+    // При этом элемент, который стал первым, мы просеиваем вниз
+    for (size_t i = 0; i + 1 < arr.size(); i++) {
+        std::swap(arr[0], arr[arrSpan.size() - 1]);
+        arrSpan = arrSpan.first(arrSpan.size() - 1);
+        siftDown(arrSpan, 0);
+    }
+}
+
+// Ниже -- d-арная куча, на которой построена основная пирамидальная сортировка.
+// У двоичной кучи выше два недостатка:
+//   1. высота дерева -- log2 n, и на массивах больше кэша почти каждый уровень
+//      просеивания -- это промах кэша;
+//   2. на каждом уровне два сравнения (выбор потомка и сравнение с родителем)
+//      и обмен тремя присваиваниями.
+// В d-арной куче у узла i потомки d * i + 1 ... d * i + d лежат подряд, а
+// высота дерева в log2 d раз меньше. Чтобы группа потомков занимала ровно одну
+// кэш-линию, а не пересекала границу двух, куча начинается не с начала
+// массива, а с такого сдвига (меньше d элементов), при котором каждая группа
+// потомков начинается с адреса, кратного d * sizeof(T) (см. heapAlignmentOffset).
+// Просеивание сделано по Флойду: элемент, который просеивается вниз, почти
+// всегда оказывается у самых листьев (при сортировке это бывший последний
+// элемент кучи -- один из самых маленьких). Поэтому мы не сравниваем его на
+// каждом уровне, а сначала спускаем "дырку" до листа по наибольшим потомкам
+// (потомки просто сдвигаются в дырку вверх -- без обменов), а затем поднимаем
+// элемент от листа на несколько уровней до его места. Пока выбираются
+// потомки, кэш-линии со следующим уровнем (внуками) уже запрашиваются из памяти.
+
+// Арность кучи в heapsort. 4 -- лучшая на наших замерах: у 8-арной кучи на
+// каждом уровне уже слишком много сравнений.
+constexpr size_t HEAPSORT_ARITY = 4;
+
+// Номер первого потомка узла в d-арной куче.
+template<size_t Arity>
+constexpr size_t heapFirstChild(size_t nodeIdx) {
+    return Arity * nodeIdx + 1;
+}
+
+// Сколько первых элементов массива arr пропустить, чтобы в куче, которая
+// начинается после них, каждая группа потомков начиналась с адреса, кратного
+// Arity * sizeof(T): тогда при Arity * sizeof(T) <= 64 группа целиком лежит в
+// одной кэш-линии. Группа потомков узла i в такой куче начинается с элемента
+// skip + Arity * i + 1 массива, поэтому достаточно, чтобы на границу
+// приходился элемент skip + 1. Если размер T -- не степень двойки, выровнять
+// группы нельзя, и куча начинается с начала массива.
+template<size_t Arity, class T>
+size_t heapAlignmentOffset(std::span<T> arr) {
+    if constexpr (!std::has_single_bit(sizeof(T))) {
+        return 0;
+    } else {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(arr.data());
+        if (address % sizeof(T) != 0) {
+            return 0;
+        }
+        const size_t index = address / sizeof(T);
+        return (Arity - (index + 1) % Arity) % Arity;
+    }
+}
+
+// Переносим count наименьших элементов массива в его начало (по возрастанию);
+// остальные элементы не меньше их. Один проход: почти каждый элемент
+// сравнивается только с наибольшим из уже отобранных.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void heapMoveSmallestToFront(std::span<T> arr, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    insertionSort(arr.first(count));
+    for (size_t k = count; k < arr.size(); k++) {
+        if (arr[k] < arr[count - 1]) {
+            std::swap(arr[k], arr[count - 1]);
+            for (size_t j = count - 1; j > 0 && arr[j] < arr[j - 1]; j--) {
+                std::swap(arr[j], arr[j - 1]);
+            }
+        }
+    }
+}
+
+// Заранее запрашиваем в кэш всех внуков узла nodeIdx (они лежат подряд).
+template<size_t Arity, class T>
+void heapPrefetchGrandchildren(std::span<T> heap, size_t nodeIdx) {
+#if defined(__GNUC__)
+    constexpr size_t step = sizeof(T) >= 64 ? 1 : 64 / sizeof(T);
+    const size_t first = heapFirstChild<Arity>(heapFirstChild<Arity>(nodeIdx));
+    const size_t last = std::min(first + Arity * Arity, heap.size());
+    for (size_t i = first; i < last; i += step) {
+        __builtin_prefetch(heap.data() + i);
+    }
+#endif
+}
+
+// Номер наибольшего из Arity элементов, начиная с first. Выбор идёт турниром
+// (попарно, затем победители пар), без условных переходов: цепочка
+// зависимых сравнений короче, чем при проходе подряд, а ветвления на
+// случайных данных предсказывались бы плохо.
+template<size_t Arity, class T>
+size_t heapLargestChild(std::span<T> heap, size_t first) {
+    if constexpr (Arity == 2) {
+        return first + static_cast<size_t>(heap[first] < heap[first + 1]);
+    } else {
+        size_t left = heapLargestChild<Arity / 2>(heap, first);
+        size_t right = heapLargestChild<Arity / 2>(heap, first + Arity / 2);
+        return heap[left] < heap[right] ? right : left;
+    }
+}
+
+// Помещаем value в "дырку" nodeIdx кучи heap так, чтобы поддерево nodeIdx
+// снова стало кучей (прежнее значение arr[nodeIdx] уже перенесено в value
+// или выброшено).
+template<size_t Arity, class T>
+requires (Arity == 2 || Arity == 4 || Arity == 8) && requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void daryHeapSiftDown(std::span<T> heap, size_t nodeIdx, T value) {
+    const size_t n = heap.size();
+    const size_t top = nodeIdx;
+    size_t hole = nodeIdx;
+
+    // Спускаем дырку по наибольшим потомкам, пока у неё есть все Arity потомков.
+    while (heapFirstChild<Arity>(hole) + Arity <= n) {
+        const size_t first = heapFirstChild<Arity>(hole);
+        heapPrefetchGrandchildren<Arity>(heap, hole);
+
+        size_t best = heapLargestChild<Arity>(heap, first);
+        heap[hole] = std::move(heap[best]);
+        hole = best;
+    }
+
+    // Последний узел может иметь неполный набор потомков.
+    if (heapFirstChild<Arity>(hole) < n) {
+        const size_t first = heapFirstChild<Arity>(hole);
+        size_t best = first;
+        for (size_t k = first + 1; k < n; k++) {
+            if (heap[best] < heap[k]) {
+                best = k;
+            }
+        }
+        heap[hole] = std::move(heap[best]);
+        hole = best;
+    }
+
+    // Поднимаем value от листа до его места (но не выше исходного узла).
+    while (hole > top) {
+        const size_t parent = (hole - 1) / Arity;
+        if (!(heap[parent] < value)) {
+            break;
+        }
+        heap[hole] = std::move(heap[parent]);
+        hole = parent;
+    }
+    heap[hole] = std::move(value);
+}
+
+// Преобразовываем массив в d-арную кучу (максимум в корне).
+template<size_t Arity, class T>
+requires (Arity == 2 || Arity == 4 || Arity == 8) && requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void daryHeapify(std::span<T> heap) {
+    if (heap.size() < 2) {
+        return;
+    }
+    // Листья уже кучи, начинаем с последнего узла, у которого есть потомки.
+    for (size_t i = (heap.size() - 2) / Arity + 1; i-- > 0;) {
+        daryHeapSiftDown<Arity>(heap, i, std::move(heap[i]));
+    }
+}
+
+// Пирамидальная сортировка на d-арной куче.
+template<size_t Arity, class T>
+requires (Arity == 2 || Arity == 4 || Arity == 8) && requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void heapsortDary(std::span<T> arr) {
+    // Пропущенные ради выравнивания первые элементы заранее занимают наименьшие
+    // значения, и сортировать кучей остаётся только остальное.
+    const size_t skip = std::min(heapAlignmentOffset<Arity>(arr), arr.size());
+    heapMoveSmallestToFront(arr, skip);
+    std::span<T> heap = arr.subspan(skip);
+
+    daryHeapify<Arity>(heap);
+
+    // Максимум из корня ставим в конец, а бывший последний элемент
+    // просеиваем из корня в оставшуюся кучу.
+    for (size_t end = heap.size(); end > 1; end--) {
+        T value = std::move(heap[end - 1]);
+        heap[end - 1] = std::move(heap[0]);
+        daryHeapSiftDown<Arity>(heap.first(end - 1), 0, std::move(value));
+    }
+}
+
+// Пирамидальная сортировка
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void heapsort(std::span<T> arr) {
+    heapsortDary<HEAPSORT_ARITY>(arr);
+}
+
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void heapsort(std::vector<T>& arr) {
+    heapsort(std::span<T>(arr));
+}
@@ -0,0 +1,26 @@
+import random
+import subprocess
+import sys
+
+# Проверка k-путевого слияния (./a.out --kmerge): сливаем 64 случайных
+# отсортированных осколка, среди которых есть пустые, а числа часто
+# повторяются в разных осколках. Слитый массив должен совпасть с
+# устойчивой сортировкой пар (число, номер осколка): равные числа идут
+# в порядке номеров осколков.
+
+random.seed(7)
+shards = [sorted(random.choices(range(20), k=random.choice([0, 1, 5, 50]))) for _ in range(64)]
+
+input_data = f"{len(shards)}\n" + "\n".join(" ".join(map(str, [len(shard)] + shard)) for shard in shards)
+proc = subprocess.run(["./a.out", "--kmerge"], input=input_data.encode(), capture_output=True)
+if proc.returncode != 0:
+    print(f"Ошибка выполнения: {proc.stderr.decode()}")
+    sys.exit(1)
+
+values, sources = [list(map(int, line.split())) for line in proc.stdout.decode().splitlines()]
+expected = sorted((value, i) for i, shard in enumerate(shards) for value in shard)
+
+if list(zip(values, sources)) != expected:
+    print("слияние неверно или неустойчиво")
+    sys.exit(1)
+print(f"ok: {len(values)} элементов из {len(shards)} осколков")
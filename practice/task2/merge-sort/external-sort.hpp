@@ -0,0 +1,457 @@
+#pragma once
+
+#include "../../common/binary-array.hpp"
+#include "loser-tree.hpp"
+#include "mergesort.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Внешняя сортировка слиянием -- для массивов, которые не помещаются в память.
+// Она работает в две фазы:
+//   1. Генерация отрезков: читаем входной файл кусками, которые помещаются
+//      в отведённую память, сортируем каждый кусок восходящей сортировкой
+//      слиянием и сбрасываем во временный файл -- получаем отсортированные
+//      "отрезки" (runs).
+//   2. Слияние: сливаем все отрезки за один проход k-путевым слиянием. Каждый
+//      отрезок читается большими последовательными блоками, и пока мы сливаем
+//      один блок, следующий уже читается в фоне (двойная буферизация); так же
+//      в фоне пишется и результат. Если отрезков так много, что на каждый не
+//      хватает памяти под два блока, сначала сливаем их группами в более
+//      длинные отрезки.
+// Вся работа с диском последовательная и крупными блоками, поэтому скорость
+// упирается в пропускную способность диска, а не в его задержки.
+
+// Блоки, которыми читаются и пишутся отрезки при слиянии.
+constexpr size_t EXTERNAL_MAX_BLOCK_BYTES = size_t{8} << 20;
+constexpr size_t EXTERNAL_MIN_BLOCK_BYTES = size_t{256} << 10;
+
+// Меньше памяти не имеет смысла: отрезки выйдут крошечными, а слияние --
+// из множества проходов.
+constexpr size_t EXTERNAL_MIN_MEMORY_BYTES = size_t{1} << 20;
+
+// Временный файл в каталоге dir. Он сразу удаляется из каталога и исчезнет
+// сам, когда закроется дескриптор (или если программа упадёт). Дескриптор
+// закрывается в деструкторе, поэтому при исключении на любом этапе
+// сортировки место на диске освобождается.
+class TemporaryFile {
+public:
+    explicit TemporaryFile(const std::string& dir) {
+        std::string path = dir + "/sort-run-XXXXXX";
+        fd_ = mkstemp(path.data());
+        if (fd_ < 0) {
+            throw std::runtime_error("cannot create temporary file in " + dir + ": " + std::strerror(errno));
+        }
+        unlink(path.c_str());
+    }
+
+    ~TemporaryFile() {
+        close();
+    }
+
+    TemporaryFile(TemporaryFile&& other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+
+    TemporaryFile& operator=(TemporaryFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            fd_ = std::exchange(other.fd_, -1);
+        }
+        return *this;
+    }
+
+    int fd() const {
+        return fd_;
+    }
+
+    // Закрываем файл раньше деструктора, чтобы сразу освободить место.
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    int fd_ = -1;
+};
+
+// Отсортированный отрезок во временном файле.
+struct ExternalRun {
+    TemporaryFile file;
+    size_t count;
+};
+
+// Поток для фонового ввода-вывода блоков. Один такой поток обслуживает
+// сразу все отрезки, которые читаются при слиянии (второй -- запись), поэтому
+// потоков ОС всего два, сколько бы отрезков ни сливалось. Операции
+// выполняются по одной в порядке очереди: submit() ставит операцию в очередь
+// и возвращает std::future, get() которого дожидается её окончания и
+// пробрасывает исключение, если операция завершилась ошибкой.
+class IoThread {
+public:
+    IoThread() : thread_([this](std::stop_token stop) { loop(stop); }) {}
+
+    IoThread(const IoThread&) = delete;
+    IoThread& operator=(const IoThread&) = delete;
+
+    std::future<void> submit(std::function<void()> job) {
+        std::packaged_task<void()> task(std::move(job));
+        std::future<void> result = task.get_future();
+        {
+            std::lock_guard lock(mutex_);
+            queue_.push_back(std::move(task));
+        }
+        wakeup_.notify_one();
+        return result;
+    }
+
+private:
+    // При остановке сначала выполняем то, что уже стоит в очереди: операции
+    // могут писать в чужие буферы, и их владельцы ждут окончания.
+    void loop(std::stop_token stop) {
+        std::unique_lock lock(mutex_);
+        while (wakeup_.wait(lock, stop, [this]() { return !queue_.empty(); })) {
+            std::packaged_task<void()> task = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable_any wakeup_;
+    std::deque<std::packaged_task<void()>> queue_;
+
+    // Объявлен последним, чтобы поток завершился раньше, чем будут
+    // уничтожены мьютекс, условная переменная и очередь.
+    std::jthread thread_;
+};
+
+// Последовательное чтение count элементов из файла блоками. Пока вызывающая
+// сторона разбирает текущий блок, следующий уже читается в фоне потоком io.
+template<class T>
+class AsyncBlockReader {
+public:
+    AsyncBlockReader(IoThread& io, int fd, off_t offset, size_t count, size_t blockElements)
+        : io_(&io), fd_(fd), offset_(offset), remaining_(count), blockElements_(blockElements) {
+        current_.reserve(blockElements_);
+        next_.reserve(blockElements_);
+        prefetch();
+        advance();
+    }
+
+    // Чтение в next_ может ещё идти -- дожидаемся его, прежде чем освободить буфер.
+    ~AsyncBlockReader() {
+        if (pending_.valid()) {
+            pending_.wait();
+        }
+    }
+
+    // При перемещении буферы не переезжают, так что идущее чтение не страдает.
+    AsyncBlockReader(AsyncBlockReader&&) = default;
+
+    bool empty() const {
+        return pos_ == current_.size();
+    }
+
+    const T& front() const {
+        return current_[pos_];
+    }
+
+    void pop() {
+        if (++pos_ == current_.size()) {
+            advance();
+        }
+    }
+
+private:
+    // Ставим в очередь чтение следующего блока в next_.
+    void prefetch() {
+        size_t count = std::min(blockElements_, remaining_);
+        next_.resize(count);
+        remaining_ -= count;
+
+        T* data = next_.data();
+        int fd = fd_;
+        off_t offset = offset_;
+        offset_ += count * sizeof(T);
+        pending_ = io_->submit([fd, data, count, offset]() {
+            preadFully(fd, data, count * sizeof(T), offset);
+        });
+    }
+
+    // Дожидаемся прочитанного блока, делаем его текущим и сразу начинаем
+    // читать следующий.
+    void advance() {
+        pending_.get();
+        std::swap(current_, next_);
+        pos_ = 0;
+        if (!current_.empty()) {
+            prefetch();
+        }
+    }
+
+    IoThread* io_;
+    int fd_;
+    off_t offset_;
+    size_t remaining_;
+    size_t blockElements_;
+    std::vector<T> current_;
+    std::vector<T> next_;
+    size_t pos_ = 0;
+    std::future<void> pending_;
+};
+
+// Последовательная запись в файл блоками. Пока заполняется текущий блок,
+// предыдущий пишется на диск в фоне потоком io.
+template<class T>
+class AsyncBlockWriter {
+public:
+    AsyncBlockWriter(IoThread& io, int fd, off_t offset, size_t blockElements)
+        : io_(&io), fd_(fd), offset_(offset), blockElements_(blockElements) {
+        current_.reserve(blockElements_);
+        spare_.reserve(blockElements_);
+    }
+
+    // Запись из spare_ может ещё идти -- дожидаемся её, прежде чем освободить буфер.
+    ~AsyncBlockWriter() {
+        if (pending_.valid()) {
+            pending_.wait();
+        }
+    }
+
+    AsyncBlockWriter(const AsyncBlockWriter&) = delete;
+    AsyncBlockWriter& operator=(const AsyncBlockWriter&) = delete;
+
+    void push(const T& value) {
+        current_.push_back(value);
+        if (current_.size() == blockElements_) {
+            flushBlock();
+        }
+    }
+
+    // Дописываем остаток и дожидаемся окончания записи.
+    void finish() {
+        flushBlock();
+        pending_.get();
+    }
+
+private:
+    void flushBlock() {
+        if (pending_.valid()) {
+            pending_.get();
+        }
+        std::swap(current_, spare_);
+        current_.clear();
+
+        const T* data = spare_.data();
+        size_t bytes = spare_.size() * sizeof(T);
+        int fd = fd_;
+        off_t offset = offset_;
+        offset_ += bytes;
+        pending_ = io_->submit([fd, data, bytes, offset]() {
+            pwriteFully(fd, data, bytes, offset);
+        });
+    }
+
+    IoThread* io_;
+    int fd_;
+    off_t offset_;
+    size_t blockElements_;
+    std::vector<T> current_;
+    std::vector<T> spare_;
+    std::future<void> pending_;
+};
+
+// Сливаем отсортированные отрезки runs в writer деревом проигравших; все
+// отрезки читаются одним потоком readIo.
+template<class T>
+void mergeRuns(
+    std::span<const ExternalRun> runs,
+    IoThread& readIo,
+    AsyncBlockWriter<T>& writer,
+    size_t blockElements
+) {
+    std::vector<AsyncBlockReader<T>> readers;
+    readers.reserve(runs.size());
+    for (const ExternalRun& run : runs) {
+        readers.emplace_back(readIo, run.file.fd(), 0, run.count, blockElements);
+    }
+
+    kWayMerge(std::span<AsyncBlockReader<T>>(readers), [&writer](const T& value) {
+        writer.push(value);
+    });
+    writer.finish();
+}
+
+// Внешняя сортировка count элементов типа T из файла inFd (начиная с inOffset)
+// в файл outFd (начиная с outOffset). memoryBytes -- сколько памяти можно занять
+// под данные, tmpDir -- каталог для временных файлов. Ход работы и время фаз
+// выводятся в stderr.
+template<class T>
+void externalSort(
+    int inFd,
+    off_t inOffset,
+    size_t count,
+    int outFd,
+    off_t outOffset,
+    size_t memoryBytes,
+    const std::string& tmpDir
+) {
+    if (memoryBytes < EXTERNAL_MIN_MEMORY_BYTES) {
+        throw std::invalid_argument("external sort needs at least " +
+                                    std::to_string(EXTERNAL_MIN_MEMORY_BYTES >> 20) + " MiB of memory");
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto milliseconds = [](Clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+    };
+
+    // Фаза 1: генерация отрезков. В памяти одновременно находятся кусок,
+    // который сортируется, буфер сортировки слиянием (ещё столько же, он
+    // выделяется один раз на все куски) и предыдущий кусок, который в это время пишется на диск.
+    const size_t runElements = std::max<size_t>(1, memoryBytes / (3 * sizeof(T)));
+    const size_t runTotal = (count + runElements - 1) / runElements;
+
+    auto phaseStart = Clock::now();
+    std::vector<ExternalRun> runs;
+    std::vector<T> chunk;
+    std::vector<T> writing;
+    std::vector<T> buffer(std::min(runElements, count));
+
+    // Потоки ввода-вывода на всю сортировку: один читает отрезки при слиянии,
+    // другой пишет отрезки и результат. Объявлены после буферов, чтобы при
+    // исключении сначала выполнить уже поставленные в очередь операции.
+    IoThread readIo;
+    IoThread writeIo;
+    std::future<void> writing_done;
+
+    for (size_t begin = 0; begin < count; begin += runElements) {
+        size_t size = std::min(runElements, count - begin);
+        chunk.resize(size);
+        preadFully(inFd, chunk.data(), size * sizeof(T), inOffset + begin * sizeof(T));
+        mergesortBottomUp(std::span<T>(chunk), std::span<T>(buffer).first(size));
+
+        // Дожидаемся записи предыдущего отрезка и отдаём текущий на запись.
+        if (writing_done.valid()) {
+            writing_done.get();
+        }
+        std::swap(chunk, writing);
+
+        runs.push_back({TemporaryFile(tmpDir), size});
+        int fd = runs.back().file.fd();
+        writing_done = writeIo.submit([fd, &writing]() {
+            pwriteFully(fd, writing.data(), writing.size() * sizeof(T), 0);
+        });
+
+        std::cerr << "run " << runs.size() << "/" << runTotal << " sorted" << std::endl;
+    }
+    if (writing_done.valid()) {
+        writing_done.get();
+    }
+    chunk = {};
+    writing = {};
+    buffer = {};
+    std::cerr << "run generation: " << milliseconds(Clock::now() - phaseStart) << " ms" << std::endl;
+
+    // Фаза 2: слияние. На каждый отрезок и на результат нужно по два блока
+    // (текущий и тот, что читается или пишется в фоне). Блоки стараемся брать
+    // не мельче EXTERNAL_MIN_BLOCK_BYTES, но не в ущерб бюджету: в память должны
+    // поместиться хотя бы три пары блоков -- два отрезка и результат.
+    phaseStart = Clock::now();
+    size_t blockBytes = std::clamp(
+        memoryBytes / (2 * (runs.size() + 1)), EXTERNAL_MIN_BLOCK_BYTES, EXTERNAL_MAX_BLOCK_BYTES);
+    blockBytes = std::min(blockBytes, memoryBytes / (2 * 3));
+    size_t blockElements = std::max<size_t>(1, blockBytes / sizeof(T));
+    size_t fanIn = std::max<size_t>(3, memoryBytes / (2 * blockElements * sizeof(T))) - 1;
+
+    // Если отрезков больше, чем можно слить за раз, сливаем их группами
+    // в более длинные отрезки, пока не останется не больше fanIn.
+    size_t pass = 0;
+    while (runs.size() > fanIn) {
+        pass++;
+        std::vector<ExternalRun> merged;
+        for (size_t begin = 0; begin < runs.size(); begin += fanIn) {
+            std::span<ExternalRun> group(runs.data() + begin, std::min(fanIn, runs.size() - begin));
+
+            ExternalRun run{TemporaryFile(tmpDir), 0};
+            for (const ExternalRun& part : group) {
+                run.count += part.count;
+            }
+
+            AsyncBlockWriter<T> writer(writeIo, run.file.fd(), 0, blockElements);
+            mergeRuns(std::span<const ExternalRun>(group), readIo, writer, blockElements);
+            for (ExternalRun& part : group) {
+                part.file.close();
+            }
+            merged.push_back(std::move(run));
+
+            std::cerr << "merge pass " << pass << ": " << merged.size() << "/"
+                      << (runs.size() + fanIn - 1) / fanIn << " runs merged" << std::endl;
+        }
+        runs = std::move(merged);
+    }
+
+    AsyncBlockWriter<T> writer(writeIo, outFd, outOffset, blockElements);
+    mergeRuns(std::span<const ExternalRun>(runs), readIo, writer, blockElements);
+    runs.clear();
+    std::cerr << "merge: " << milliseconds(Clock::now() - phaseStart) << " ms" << std::endl;
+}
+
+// Внешняя сортировка двоичного массива из файла inputPath в файл outputPath.
+inline void externalSortFile(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    size_t memoryBytes,
+    const std::string& tmpDir
+) {
+    int inFd = open(inputPath.c_str(), O_RDONLY);
+    if (inFd < 0) {
+        throw std::runtime_error("cannot open " + inputPath + ": " + std::strerror(errno));
+    }
+
+    int outFd = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outFd < 0) {
+        close(inFd);
+        throw std::runtime_error("cannot create " + outputPath + ": " + std::strerror(errno));
+    }
+
+    try {
+        BinaryArrayHeader header = readBinaryArrayHeader(inFd);
+        pwriteFully(outFd, &header, sizeof(header), 0);
+
+        visitElementType(header.type, nullptr, 0, [&](auto tag) {
+            using T = typename decltype(tag)::value_type;
+            externalSort<T>(inFd, sizeof(header), header.count, outFd, sizeof(header), memoryBytes, tmpDir);
+        });
+    } catch (...) {
+        close(inFd);
+        close(outFd);
+        throw;
+    }
+
+    close(inFd);
+    close(outFd);
+}
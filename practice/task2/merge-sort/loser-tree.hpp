@@ -0,0 +1,185 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Источник для k-путевого слияния: отсортированная последовательность,
+// из которой можно посмотреть первый элемент и убрать его. Это может быть
+// массив в памяти (SpanSource ниже), блочное чтение файла из внешней
+// сортировки или, например, курсор по результатам запроса.
+template<class S>
+concept MergeSource = requires(S source, const S constSource) {
+    { constSource.empty() } -> std::convertible_to<bool>;
+    constSource.front();
+    source.pop();
+};
+
+template<MergeSource S>
+using MergeSourceValue = std::remove_cvref_t<decltype(std::declval<const S&>().front())>;
+
+// Отсортированный массив как источник слияния.
+template<class T>
+class SpanSource {
+public:
+    explicit SpanSource(std::span<const T> data) : data_(data) {}
+
+    bool empty() const {
+        return pos_ == data_.size();
+    }
+
+    const T& front() const {
+        return data_[pos_];
+    }
+
+    void pop() {
+        pos_++;
+    }
+
+private:
+    std::span<const T> data_;
+    size_t pos_ = 0;
+};
+
+// Дерево проигравших (турнирное дерево) для k-путевого слияния.
+//
+// Сливать k отрезков попарно -- значит пройти по данным log k раз. Куча
+// позволяет сделать это за один проход, но на каждом шаге просеивания
+// делает по два сравнения на уровень. В дереве проигравших каждый
+// внутренний узел хранит проигравшего в "матче" между своими поддеревьями,
+// а победитель всего турнира хранится отдельно. Когда победитель забран и
+// его источник выдал следующий элемент, достаточно переиграть матчи только
+// на пути от его листа к корню -- ровно одно сравнение на уровень, т.е.
+// около log k сравнений на элемент.
+//
+// Дерево хранится неявно, как куча: у узла j родитель j / 2, а лист
+// источника i имеет номер k + i. Узлы лежат в одном массиве и содержат
+// копию текущего ключа источника, поэтому матчи сравнивают соседние в
+// памяти записи и не обращаются к самим источникам, а верхние уровни,
+// через которые проходит каждый путь, всегда находятся в кэше.
+template<MergeSource Source>
+class LoserTree {
+public:
+    using Value = MergeSourceValue<Source>;
+
+    explicit LoserTree(std::span<Source> sources) : sources_(sources), nodes_(sources.size()) {
+        const size_t k = sources_.size();
+        if (k == 0) {
+            return;
+        }
+
+        // Разыгрываем турнир снизу вверх: winners[j] -- победитель поддерева
+        // с корнем j, а в nodes_[j] остаётся проигравший.
+        std::vector<Entry> winners(2 * k);
+        for (size_t i = 0; i < k; i++) {
+            winners[k + i] = entryOf(static_cast<uint32_t>(i));
+        }
+        for (size_t j = k - 1; j > 0; j--) {
+            Entry& left = winners[2 * j];
+            Entry& right = winners[2 * j + 1];
+            if (beats(left, right)) {
+                winners[j] = std::move(left);
+                nodes_[j] = std::move(right);
+            } else {
+                winners[j] = std::move(right);
+                nodes_[j] = std::move(left);
+            }
+        }
+        nodes_[0] = std::move(winners[k == 1 ? k : 1]);
+    }
+
+    // Все источники исчерпаны.
+    bool empty() const {
+        return nodes_.empty() || nodes_[0].exhausted;
+    }
+
+    // Наименьший из первых элементов источников.
+    const Value& top() const {
+        return nodes_[0].key;
+    }
+
+    // Номер источника, которому принадлежит top().
+    size_t topSource() const {
+        return nodes_[0].source;
+    }
+
+    // Забираем top() из его источника и переигрываем матчи на пути к корню.
+    void pop() {
+        const uint32_t source = nodes_[0].source;
+        sources_[source].pop();
+
+        Entry winner = entryOf(source);
+        for (size_t j = (sources_.size() + source) / 2; j > 0; j /= 2) {
+            if (beats(nodes_[j], winner)) {
+                std::swap(nodes_[j], winner);
+            }
+        }
+        nodes_[0] = std::move(winner);
+    }
+
+private:
+    struct Entry {
+        Value key{};
+        uint32_t source = 0;
+        bool exhausted = true;
+    };
+
+    Entry entryOf(uint32_t source) const {
+        if (sources_[source].empty()) {
+            return Entry{Value{}, source, true};
+        }
+        return Entry{sources_[source].front(), source, false};
+    }
+
+    // Выигрывает ли a у b. Исчерпанный источник проигрывает всем, а при равных
+    // ключах выигрывает источник с меньшим номером -- так слияние устойчиво.
+    static bool beats(const Entry& a, const Entry& b) {
+        if (a.exhausted || b.exhausted) {
+            return !a.exhausted || (b.exhausted && a.source < b.source);
+        }
+        if (a.key < b.key) {
+            return true;
+        }
+        if (b.key < a.key) {
+            return false;
+        }
+        return a.source < b.source;
+    }
+
+    std::span<Source> sources_;
+
+    // nodes_[0] -- победитель, nodes_[1..k-1] -- проигравшие во внутренних узлах.
+    std::vector<Entry> nodes_;
+};
+
+// Сливаем отсортированные источники sources за один проход, передавая
+// элементы по возрастанию в output. Слияние устойчивое: равные элементы
+// идут в порядке номеров источников.
+template<MergeSource Source, class Output>
+void kWayMerge(std::span<Source> sources, Output&& output) {
+    LoserTree<Source> tree(sources);
+    while (!tree.empty()) {
+        output(tree.top());
+        tree.pop();
+    }
+}
+
+// Сливаем отсортированные массивы inputs в out (размер out должен быть
+// равен суммарному размеру inputs).
+template<class T>
+void kWayMerge(std::span<const std::span<const T>> inputs, std::span<T> out) {
+    std::vector<SpanSource<T>> sources;
+    sources.reserve(inputs.size());
+    for (std::span<const T> input : inputs) {
+        sources.emplace_back(input);
+    }
+
+    size_t k = 0;
+    kWayMerge(std::span<SpanSource<T>>(sources), [&out, &k](const T& value) {
+        out[k++] = value;
+    });
+}
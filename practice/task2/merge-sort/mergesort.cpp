@@ -1,181 +1,252 @@
+#include "../../common/binary-array.hpp"
+#include "../../common/fast-io.hpp"
+#include "../../common/indirect-sort.hpp"
+#include "external-sort.hpp"
+#include "loser-tree.hpp"
+#include "mergesort.hpp"
+#include "timsort.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
 #include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
-#include <chrono>
-
-// В основе сортировки слиянием находится, как ни странно, слияние.
-// Это операция, которая объединяет два отсортированных массива в один
-// отсортированный массив.
-template<class T>
-requires requires (const T& a, const T& b) {
-   { a < b } -> std::convertible_to<bool>;
-   { a > b } -> std::convertible_to<bool>;
-}
-void merge(
-    // Массив, слева содержащий левый подмассив, справа содержащий правый.
-    std::vector<T>& arr,
-
-    // Границы левого и правого подмассивов определяются тремя аргументами ниже:
-    // [left; mid) и [mid; right)
-    size_t left,
-    size_t mid,
-    size_t right,
-
-    // Слияние мы будем проводить в вектор arr, принимаемый в качестве первого аргумента.
-    // Однако во время записи в arr мы можем потерять исходное положение элементов в подмассивах,
-    // поэтому нам необходимо их сохранить в векторах leftArr и rightArr.
-    //
-    // Эти вектора можно создать и внутри функции merge, однако в таком случае
-    // они будут реаллоцироваться на каждый вызов функции merge.
-    // Поскольку merge ниже вызывается в рекурсивной функции, каждый раз разбивающий массив
-    // на две половины до тех пор, пока полученные массивы не окажутся пустыми, то
-    // количество вызовов merge составит O(log(n)), а это значит мы будет обращаться к ОС
-    // для аллокации памяти в куче O(log(n)) раза. Очевидно, что системный вызов для аллокации
-    // памяти в куче -- это дорого, надо это минимизировать.
-    //
-    // Вместо этого мы можем один раз аллоцировать два вектора, зарезервировав перед их
-    // использованием место под [n / 2] и [n / 2] + 1 элементов соответственно (capacity) при
-    // помощи метода reserve, а их size мы будем менять при помощи метода resize на каждый вызов.
-    // Таким образом мы будем как-будто работать с векторами, имеющими нужный нам размер, но на
-    // самом деле один раз мы аллоцируем место для самых больших подмассивов и это место
-    // переиспользуем на каждый вызов merge, тем самым у нас будет лишь O(1) обращения к ОС
-    // для аллокации памяти.
-    std::vector<T>& leftArr,
-    std::vector<T>& rightArr
-) {
-    leftArr.resize(mid - left + 1);
-    rightArr.resize(right - mid);
-
-    // Копируем элементы в левый и правый подмассивы из arr.
-    for (size_t i = 0; i < leftArr.size(); i++) {
-        leftArr[i] = arr[left + i];
-    }
 
-    for (size_t i = 0; i < rightArr.size(); i++) {
-        rightArr[i] = arr[mid + 1 + i];
+// Элемент осколка для --kmerge: число и номер осколка, из которого оно
+// взято. Сравниваются только числа, поэтому по номерам осколков в выводе
+// видно, в каком порядке слияние расставило равные элементы.
+struct ShardValue {
+    int value = 0;
+    uint32_t shard = 0;
+
+    friend bool operator<(const ShardValue& a, const ShardValue& b) {
+        return a.value < b.value;
+    }
+};
+
+// Режим --kmerge: на вход подаётся количество осколков k и за ним k
+// отсортированных массивов в обычном формате (n и n чисел). Осколки
+// сливаются k-путевым слиянием на дереве проигравших, выводятся слитый
+// массив и во второй строке -- номера осколков его элементов (при равных
+// числах они должны идти по возрастанию: слияние устойчиво).
+int runKWayMerge(bool benchmark_mode, bool timings_mode) {
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
+
+    // считываем осколки
+    std::vector<std::vector<ShardValue>> shards;
+    try {
+        timings.parse = measureMicroseconds([&]() {
+            size_t k = 0;
+            if (!input.read(k)) {
+                throw std::runtime_error("invalid shard count");
+            }
+            shards.resize(k);
+            for (size_t i = 0; i < k; i++) {
+                for (int value : input.readArray<int>()) {
+                    shards[i].push_back({value, static_cast<uint32_t>(i)});
+                }
+                if (!std::is_sorted(shards[i].begin(), shards[i].end())) {
+                    throw std::runtime_error("shard #" + std::to_string(i + 1) + " is not sorted");
+                }
+            }
+        });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
-    size_t i = 0;     // Текущий элемент левого подмассива
-    size_t j = 0;     // Текущий элемент правого подмассива
-    size_t k = left;  // Текущий элемент массива arr
-
-    // Производим операцию слияния, пока один из указателей в левом
-    // или правом подмассиве не дошёл до последнего элемента.
-    while (i < leftArr.size() && j < rightArr.size()) {
-        if (leftArr[i] <= rightArr[j]) {
-            // Если текущий элемент левого подмассива не больше текущего элемента
-            // правого подмассива, то мы кладём в arr текущий элемент левого подмассива
-            // и переходим к следующему элементу левого подмассива.
-            arr[k++] = leftArr[i++];
-        } else {
-            // В противном случае мы кладём в arr текущий элемент правого подмассива
-            // и переходим к следующему элементу правого подмассива.
-            arr[k++] = rightArr[j++];
-        }
+    // сливаем осколки
+    std::vector<std::span<const ShardValue>> inputs;
+    size_t total = 0;
+    for (const std::vector<ShardValue>& shard : shards) {
+        inputs.emplace_back(shard);
+        total += shard.size();
     }
+    std::vector<ShardValue> merged(total);
+    timings.sort = measureMicroseconds([&]() {
+        kWayMerge(std::span<const std::span<const ShardValue>>(inputs), std::span<ShardValue>(merged));
+    });
 
-    // Если в левом подмассиве мы не дошли до конца, значит в нём остались
-    // элементы, которые мы не переложили. Перекладываем.
-    while (i < leftArr.size()) {
-        arr[k++] = leftArr[i++];
+    if (benchmark_mode) {
+        output.write(timings.sort);
+        output.write('\n');
+    } else {
+        timings.write = measureMicroseconds([&]() {
+            for (const ShardValue& item : merged) {
+                output.write(item.value);
+                output.write(' ');
+            }
+            output.write('\n');
+            for (const ShardValue& item : merged) {
+                output.write(item.shard);
+                output.write(' ');
+            }
+            output.write('\n');
+            output.flush();
+        });
     }
 
-    // Аналогично для правого подмассива.
-    while (j < rightArr.size()) {
-        arr[k++] = rightArr[j++];
+    if (timings_mode) {
+        timings.report();
     }
+    return 0;
 }
 
-// Это перегрузка функции mergesort, которая будет вызываться рекурсивно.
-// Простым работягам-программистам следует применять перегрузку, описанную ниже)
-template<class T>
-requires requires (const T& a, const T& b) {
-   { a < b } -> std::convertible_to<bool>;
-   { a > b } -> std::convertible_to<bool>;
-}
-void mergesort(
-    // Массив, который мы сортируем.
-    std::vector<T>& arr,
-
-    // Левая и правая граница подмассива.
-    size_t left,
-    size_t right,
-
-    // Смотреть описание аналогичных аргументов в функции merge.
-    std::vector<T>& leftArr,
-    std::vector<T>& rightArr
-) {
-    if (left >= right) {
-        return;
-    }
+int main(int argc, char* argv[]) {
+    bool benchmark_mode = false;
 
-    // Разделяем два подмассива на две равные половинки
-    // (или почти равные, если количество элементов arr нечётное).
-    size_t mid = left + (right - left) / 2;
+    // --timings выводит в stderr время разбора ввода, сортировки и вывода
+    bool timings_mode = false;
+
+    // --binary FILE сортирует двоичный файл на месте вместо текстового ввода
+    std::string binary_path;
+
+    // --indirect сортирует косвенно: выбранный вариант упорядочивает компактные
+    // записи "префикс ключа + указатель на элемент", а сами элементы затем
+    // переставляются на свои места по одному разу (для тяжёлых элементов)
+    bool indirect_mode = false;
+
+    // --external INPUT OUTPUT сортирует двоичный файл, который не помещается
+    // в память, в файл OUTPUT; --memory MB ограничивает занимаемую при этом
+    // память (256 МиБ по умолчанию), --tmp DIR задаёт каталог для временных файлов
+    std::string external_input;
+    std::string external_output;
+    size_t memory_mb = 256;
+    std::string tmp_dir = std::getenv("TMPDIR") != nullptr ? std::getenv("TMPDIR") : "/tmp";
+
+    // --kmerge сливает уже отсортированные осколки (см. runKWayMerge)
+    bool kmerge_mode = false;
+
+    // --mode выбирает вариант сортировки:
+    // classic -- рекурсивная сортировка слиянием (по умолчанию),
+    // bottomup -- восходящая сортировка слиянием с одним буфером,
+    // parallel -- параллельная сортировка слиянием,
+    // adaptive -- естественная сортировка слиянием (TimSort) для почти упорядоченных данных
+    std::string mode = "classic";
+
+    // количество потоков для --mode parallel задаётся флагом --threads,
+    // по умолчанию -- все ядра
+    size_t threads = std::thread::hardware_concurrency();
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--benchmark") {
+                benchmark_mode = true;
+            } else if (arg == "--timings") {
+                timings_mode = true;
+            } else if (arg == "--kmerge") {
+                kmerge_mode = true;
+            } else if (arg == "--indirect") {
+                indirect_mode = true;
+            } else if (arg == "--binary" && i + 1 < argc) {
+                binary_path = argv[++i];
+            } else if (arg == "--external" && i + 2 < argc) {
+                external_input = argv[++i];
+                external_output = argv[++i];
+            } else if (arg == "--memory" && i + 1 < argc) {
+                memory_mb = parseFlagValue(arg, argv[++i]);
+                if (memory_mb > (SIZE_MAX >> 20)) {
+                    throw std::invalid_argument("invalid value for --memory: " + std::to_string(memory_mb));
+                }
+            } else if (arg == "--tmp" && i + 1 < argc) {
+                tmp_dir = argv[++i];
+            } else if (arg == "--mode" && i + 1 < argc) {
+                mode = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                threads = parseFlagValue(arg, argv[++i]);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 
-    // Рекурсивно сортируем левую и правую половинки.
-    mergesort(arr, left, mid, leftArr, rightArr);
-    mergesort(arr, mid + 1, right, leftArr, rightArr);
+    // сортировка выбранным вариантом
+    auto sortDirect = [&mode, threads](auto arr) {
+        if (mode == "bottomup") {
+            mergesortBottomUp(arr);
+        } else if (mode == "parallel") {
+            mergesortParallel(arr, threads);
+        } else if (mode == "adaptive") {
+            timsort(arr);
+        } else {
+            mergesort(arr);
+        }
+    };
 
-    // Сливаем воедино две отсортированные половинки.
-    merge(arr, left, mid, right, leftArr, rightArr);
-}
+    auto sort = [&sortDirect, indirect_mode](auto arr) {
+        if (indirect_mode) {
+            sortIndirect(arr, sortDirect);
+        } else {
+            sortDirect(arr);
+        }
+    };
 
-// Это перегрузка функции -- простой чилловый парень: он просто принимает
-// на вход вектор и сортирует его, без всяких заморочек, все заморочки с
-// аллоцированием дополнительных векторов для двух подмассивов или с
-// передачей дополнительных аргументов для того, чтобы рекурсия работала,
-// эта перегрузка функции инкапсулирует за собой. Настоящий герой!
-template<class T>
-requires requires (const T& a, const T& b) {
-   { a < b } -> std::convertible_to<bool>;
-   { a > b } -> std::convertible_to<bool>;
-}
-void mergesort(std::vector<T>& arr) {
-    // Смотреть описание последних двух аргументов функции merge.
-    std::vector<T> leftArr;
-    leftArr.reserve(arr.size() / 2);
+    if (mode != "classic" && mode != "bottomup" && mode != "parallel"
+        && mode != "adaptive") {
+        std::cerr << "Неизвестный вариант сортировки: " << mode << std::endl;
+        return 1;
+    }
 
-    std::vector<T> rightArr;
-    rightArr.reserve(arr.size() / 2 + 1);
+    if (kmerge_mode) {
+        return runKWayMerge(benchmark_mode, timings_mode);
+    }
 
-    // сортируем массив
-    mergesort(arr, 0, arr.size() - 1, leftArr, rightArr);
-}
+    if (!external_input.empty()) {
+        try {
+            long long duration = measureMicroseconds([&]() {
+                externalSortFile(external_input, external_output, memory_mb << 20, tmp_dir);
+            });
+            if (benchmark_mode) {
+                std::cout << duration << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-int main(int argc, char* argv[]) {
-    bool benchmark_mode = false;
-    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
-        benchmark_mode = true;
+    if (!binary_path.empty()) {
+        return sortBinaryFile(binary_path, benchmark_mode, timings_mode, sort);
     }
 
-    int n;  // кол-во элементов
-    std::cin >> n;
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
 
-    // указываем capacity = n, тем самым сразу аллоцировав место под n элеметов
+    // считываем массив
     std::vector<int> arr;
-    arr.reserve(n);
-
-    // заполняем массив
-    for (int i = 0; i < n; i++) {
-        int num;
-        std::cin >> num;
-        arr.push_back(num);
+    try {
+        timings.parse = measureMicroseconds([&]() { arr = input.readArray<int>(); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
     // сортируем массив
+    timings.sort = measureMicroseconds([&]() { sort(std::span<int>(arr)); });
+
     if (benchmark_mode) {
-        auto start = std::chrono::high_resolution_clock::now();
-        mergesort(arr);
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        std::cout << duration.count() << std::endl;
+        output.write(timings.sort);
+        output.write('\n');
     } else {
-        mergesort(arr);
-
         // выводим массив на экран
-        for (int num : arr) {
-            std::cout << num << " ";
-        }
-        std::cout << std::endl;
+        timings.write = measureMicroseconds([&]() {
+            output.writeArray(std::span<const int>(arr));
+            output.flush();
+        });
+    }
+
+    if (timings_mode) {
+        timings.report();
     }
 }
@@ -0,0 +1,383 @@
+#pragma once
+
+#include "../../common/insertion-sort.hpp"
+#include "../../common/sorting-network.hpp"
+
+#include <algorithm>
+#include <barrier>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// В основе сортировки слиянием находится, как ни странно, слияние.
+// Это операция, которая объединяет два отсортированных массива в один
+// отсортированный массив.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void merge(
+    // Массив, слева содержащий левый подмассив, справа содержащий правый.
+    std::span<T> arr,
+
+    // Границы левого и правого подмассивов определяются тремя аргументами ниже:
+    // [left; mid) и [mid; right)
+    size_t left,
+    size_t mid,
+    size_t right,
+
+    // Слияние мы будем проводить в вектор arr, принимаемый в качестве первого аргумента.
+    // Однако во время записи в arr мы можем потерять исходное положение элементов в подмассивах,
+    // поэтому нам необходимо их сохранить в векторах leftArr и rightArr.
+    //
+    // Эти вектора можно создать и внутри функции merge, однако в таком случае
+    // они будут реаллоцироваться на каждый вызов функции merge.
+    // Поскольку merge ниже вызывается в рекурсивной функции, каждый раз разбивающий массив
+    // на две половины до тех пор, пока полученные массивы не окажутся пустыми, то
+    // количество вызовов merge составит O(log(n)), а это значит мы будет обращаться к ОС
+    // для аллокации памяти в куче O(log(n)) раза. Очевидно, что системный вызов для аллокации
+    // памяти в куче -- это дорого, надо это минимизировать.
+    //
+    // Вместо этого мы можем один раз аллоцировать два вектора, зарезервировав перед их
+    // использованием место под [n / 2] и [n / 2] + 1 элементов соответственно (capacity) при
+    // помощи метода reserve, а их size мы будем менять при помощи метода resize на каждый вызов.
+    // Таким образом мы будем как-будто работать с векторами, имеющими нужный нам размер, но на
+    // самом деле один раз мы аллоцируем место для самых больших подмассивов и это место
+    // переиспользуем на каждый вызов merge, тем самым у нас будет лишь O(1) обращения к ОС
+    // для аллокации памяти.
+    std::vector<T>& leftArr,
+    std::vector<T>& rightArr
+) {
+    leftArr.resize(mid - left + 1);
+    rightArr.resize(right - mid);
+
+    // Копируем элементы в левый и правый подмассивы из arr.
+    for (size_t i = 0; i < leftArr.size(); i++) {
+        leftArr[i] = arr[left + i];
+    }
+
+    for (size_t i = 0; i < rightArr.size(); i++) {
+        rightArr[i] = arr[mid + 1 + i];
+    }
+
+    size_t i = 0;     // Текущий элемент левого подмассива
+    size_t j = 0;     // Текущий элемент правого подмассива
+    size_t k = left;  // Текущий элемент массива arr
+
+    // Производим операцию слияния, пока один из указателей в левом
+    // или правом подмассиве не дошёл до последнего элемента.
+    while (i < leftArr.size() && j < rightArr.size()) {
+        if (leftArr[i] <= rightArr[j]) {
+            // Если текущий элемент левого подмассива не больше текущего элемента
+            // правого подмассива, то мы кладём в arr текущий элемент левого подмассива
+            // и переходим к следующему элементу левого подмассива.
+            arr[k++] = leftArr[i++];
+        } else {
+            // В противном случае мы кладём в arr текущий элемент правого подмассива
+            // и переходим к следующему элементу правого подмассива.
+            arr[k++] = rightArr[j++];
+        }
+    }
+
+    // Если в левом подмассиве мы не дошли до конца, значит в нём остались
+    // элементы, которые мы не переложили. Перекладываем.
+    while (i < leftArr.size()) {
+        arr[k++] = leftArr[i++];
+    }
+
+    // Аналогично для правого подмассива.
+    while (j < rightArr.size()) {
+        arr[k++] = rightArr[j++];
+    }
+}
+
+// Это перегрузка функции mergesort, которая будет вызываться рекурсивно.
+// Простым работягам-программистам следует применять перегрузку, описанную ниже)
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void mergesort(
+    // Массив, который мы сортируем.
+    std::span<T> arr,
+
+    // Левая и правая граница подмассива.
+    size_t left,
+    size_t right,
+
+    // Смотреть описание аналогичных аргументов в функции merge.
+    std::vector<T>& leftArr,
+    std::vector<T>& rightArr
+) {
+    if (left >= right) {
+        return;
+    }
+
+    // Разделяем два подмассива на две равные половинки
+    // (или почти равные, если количество элементов arr нечётное).
+    size_t mid = left + (right - left) / 2;
+
+    // Рекурсивно сортируем левую и правую половинки.
+    mergesort(arr, left, mid, leftArr, rightArr);
+    mergesort(arr, mid + 1, right, leftArr, rightArr);
+
+    // Сливаем воедино две отсортированные половинки.
+    merge(arr, left, mid, right, leftArr, rightArr);
+}
+
+// Это перегрузка функции -- простой чилловый парень: он просто принимает
+// на вход массив и сортирует его, без всяких заморочек, все заморочки с
+// аллоцированием дополнительных векторов для двух подмассивов или с
+// передачей дополнительных аргументов для того, чтобы рекурсия работала,
+// эта перегрузка функции инкапсулирует за собой. Настоящий герой!
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void mergesort(std::span<T> arr) {
+    // Пустой массив уже отсортирован (а arr.size() - 1 ниже для него переполнилось бы).
+    if (arr.empty()) {
+        return;
+    }
+
+    // Смотреть описание последних двух аргументов функции merge.
+    std::vector<T> leftArr;
+    leftArr.reserve(arr.size() / 2);
+
+    std::vector<T> rightArr;
+    rightArr.reserve(arr.size() / 2 + 1);
+
+    // сортируем массив
+    mergesort(arr, 0, arr.size() - 1, leftArr, rightArr);
+}
+
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void mergesort(std::vector<T>& arr) {
+    mergesort(std::span<T>(arr));
+}
+
+// Ниже -- восходящая (итеративная) сортировка слиянием. Версия выше на каждом
+// слиянии копирует обе половины в leftArr и rightArr и только потом сливает их
+// обратно, т.е. на каждом уровне рекурсии каждый элемент перекладывается
+// дважды. Здесь же слияние идёт сразу из массива в буфер размера n, на
+// следующем уровне -- из буфера обратно в массив и т.д. ("пинг-понг"), так что
+// на уровень приходится одно перемещение элемента, и элементы именно
+// перемещаются (std::move), а не копируются. Рекурсии нет вовсе: сначала
+// небольшие блоки сортируются вставками (целые числа -- векторной сетью), а
+// затем соседние отсортированные отрезки сливаются попарно, каждый раз
+// удваивая их длину.
+
+// Блоки такого размера сортируются вставками перед первым слиянием.
+constexpr size_t MERGESORT_INSERTION_THRESHOLD = 32;
+
+// Размер блоков, которые сортируются до первого слияния. Целые числа
+// сортируются векторной сетью, и блоки для них берутся крупнее.
+template<class T>
+constexpr size_t mergesortBlockSize() {
+    if constexpr (SortingNetworkType<T> && std::integral<T>) {
+        return SORTING_NETWORK_MAX;
+    }
+    return MERGESORT_INSERTION_THRESHOLD;
+}
+
+// Сливаем отсортированные left и right в out (out.size() == left.size() + right.size()),
+// перемещая элементы. При равенстве первым идёт элемент из left, так что
+// слияние устойчиво.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void mergeInto(std::span<T> left, std::span<T> right, std::span<T> out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+
+    // Выбор источника сделан без условного перехода: на случайных данных он
+    // предсказывался бы неверно в половине случаев.
+    while (i < left.size() && j < right.size()) {
+        const bool takeRight = right[j] < left[i];
+        out[k++] = std::move(takeRight ? right[j] : left[i]);
+        j += takeRight;
+        i += !takeRight;
+    }
+
+    std::move(left.begin() + i, left.end(), out.begin() + k);
+    std::move(right.begin() + j, right.end(), out.begin() + k + (left.size() - i));
+}
+
+// Восходящая сортировка слиянием с буфером buffer (buffer.size() == arr.size()).
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void mergesortBottomUp(std::span<T> arr, std::span<T> buffer) {
+    const size_t n = arr.size();
+
+    constexpr size_t block = mergesortBlockSize<T>();
+    for (size_t begin = 0; begin < n; begin += block) {
+        smallSortStable(arr.subspan(begin, std::min(block, n - begin)));
+    }
+
+    std::span<T> from = arr;
+    std::span<T> to = buffer;
+
+    for (size_t width = block; width < n; width *= 2) {
+        for (size_t left = 0; left < n; left += 2 * width) {
+            const size_t mid = std::min(left + width, n);
+            const size_t right = std::min(left + 2 * width, n);
+
+            // Если последний элемент левого отрезка не больше первого элемента
+            // правого, отрезки уже идут по порядку, и сравнивать ничего не нужно
+            // -- достаточно переложить их целиком (на почти отсортированных
+            // данных так пропускается большая часть слияний).
+            if (mid == right || !(from[mid] < from[mid - 1])) {
+                std::move(from.begin() + left, from.begin() + right, to.begin() + left);
+            } else {
+                mergeInto(from.subspan(left, mid - left), from.subspan(mid, right - mid), to.subspan(left, right - left));
+            }
+        }
+        std::swap(from, to);
+    }
+
+    // После нечётного числа уровней результат оказался в буфере.
+    if (from.data() != arr.data()) {
+        std::move(from.begin(), from.end(), arr.begin());
+    }
+}
+
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void mergesortBottomUp(std::span<T> arr) {
+    if (arr.size() <= mergesortBlockSize<T>()) {
+        smallSortStable(arr);
+        return;
+    }
+
+    std::vector<T> buffer(arr.size());
+    mergesortBottomUp(arr, std::span<T>(buffer));
+}
+
+// Параллельная сортировка слиянием. Если просто сортировать половины в разных
+// потоках, последнее слияние двух половин по n/2 элементов всё равно делает
+// один поток, и ускорение упирается в него. Поэтому здесь делится не массив
+// на половины, а работа каждого слияния -- по позициям результата:
+//   1. массив делится на threadCount кусков, и каждый поток сортирует свой
+//      кусок восходящей сортировкой слиянием;
+//   2. затем уровень за уровнем сливаются соседние отсортированные отрезки, но
+//      каждый поток вычисляет не "своё" слияние, а свою часть результата --
+//      ровно столько элементов, сколько было в его куске. Где в сливаемых
+//      отрезках начинается его часть, находит двоичный поиск по "пути
+//      слияния" (co-rank, см. mergeCoRank).
+// Так на каждом уровне, включая последний, заняты все потоки, и каждый из них
+// сливает одинаковое число элементов. Между уровнями потоки синхронизируются
+// барьером, а данные, как и в восходящей сортировке, ходят между массивом и
+// одним буфером.
+
+// Куски меньше этого размера не стоит сортировать в отдельном потоке.
+constexpr size_t MERGESORT_PARALLEL_GRAIN = 1 << 16;
+
+// Сколько элементов из left попадёт в первые k элементов устойчивого слияния
+// left и right (остальные k - i -- из right). Ищется наименьшее i, при котором
+// right[k - i - 1] < left[i]: при равенстве первыми идут элементы left.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+size_t mergeCoRank(size_t k, std::span<const T> left, std::span<const T> right) {
+    size_t low = k > right.size() ? k - right.size() : 0;
+    size_t high = std::min(k, left.size());
+
+    while (low < high) {
+        size_t i = low + (high - low) / 2;
+        if (right[k - i - 1] < left[i]) {
+            high = i;
+        } else {
+            low = i + 1;
+        }
+    }
+    return low;
+}
+
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void mergesortParallel(std::span<T> arr, size_t threadCount = std::thread::hardware_concurrency()) {
+    const size_t n = arr.size();
+    threadCount = std::clamp<size_t>(n / MERGESORT_PARALLEL_GRAIN, 1, std::max<size_t>(threadCount, 1));
+    if (threadCount == 1) {
+        mergesortBottomUp(arr);
+        return;
+    }
+
+    std::vector<T> buffer(n);
+    std::barrier sync(static_cast<std::ptrdiff_t>(threadCount));
+
+    auto chunkBegin = [n, threadCount](size_t c) { return c * n / threadCount; };
+
+    auto worker = [&](size_t t) {
+        const size_t begin = chunkBegin(t);
+        const size_t end = chunkBegin(t + 1);
+        mergesortBottomUp(arr.subspan(begin, end - begin), std::span<T>(buffer).subspan(begin, end - begin));
+
+        std::span<T> from = arr;
+        std::span<T> to = buffer;
+
+        // width -- длина сливаемых отрезков в кусках.
+        for (size_t width = 1; width < threadCount; width *= 2) {
+            sync.arrive_and_wait();
+
+            // Слияние, которому принадлежит часть результата [begin; end):
+            // отрезки из кусков [first; mid) и [mid; last).
+            const size_t first = t / (2 * width) * (2 * width);
+            const size_t mid = std::min(first + width, threadCount);
+            const size_t last = std::min(first + 2 * width, threadCount);
+
+            const size_t mergeBegin = chunkBegin(first);
+            std::span<const T> left(from.data() + mergeBegin, chunkBegin(mid) - mergeBegin);
+            std::span<const T> right(from.data() + chunkBegin(mid), chunkBegin(last) - chunkBegin(mid));
+
+            const size_t leftFrom = mergeCoRank(begin - mergeBegin, left, right);
+            const size_t leftTo = mergeCoRank(end - mergeBegin, left, right);
+            const size_t rightFrom = begin - mergeBegin - leftFrom;
+            const size_t rightTo = end - mergeBegin - leftTo;
+
+            mergeInto(
+                from.subspan(mergeBegin + leftFrom, leftTo - leftFrom),
+                from.subspan(chunkBegin(mid) + rightFrom, rightTo - rightFrom),
+                to.subspan(begin, end - begin));
+            std::swap(from, to);
+        }
+
+        // После нечётного числа уровней результат оказался в буфере. Переносить
+        // его можно только после того, как все потоки дочитали массив.
+        if (from.data() != arr.data()) {
+            sync.arrive_and_wait();
+            std::move(from.begin() + begin, from.begin() + end, arr.begin() + begin);
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(threadCount - 1);
+    for (size_t t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+}
@@ -0,0 +1,452 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Адаптивная сортировка слиянием в духе TimSort (Python, Java). Обычная
+// сортировка слиянием делает O(n log n) работы даже на уже отсортированном
+// массиве. Но реальные данные часто почти упорядочены -- например, журнал,
+// в который записи дописываются в конец. Такая сортировка:
+//   1. Ищет в массиве естественные отрезки ("серии"): неубывающие или строго
+//      убывающие (убывающие разворачиваются на месте; строгость нужна, чтобы
+//      разворот не переставил равные элементы и сортировка осталась
+//      устойчивой). Слишком короткие серии дополняются до minRun элементов
+//      сортировкой бинарными вставками.
+//   2. Складывает серии в стек и сливает соседние так, чтобы длины серий в
+//      стеке росли хотя бы как числа Фибоначчи: тогда сливаются серии
+//      сравнимой длины (как в сбалансированном дереве слияний), стек остаётся
+//      глубиной O(log n), а общая работа -- O(n log n).
+//   3. При слиянии "галопирует": если из одной серии подряд берутся много
+//      элементов, граница дальше ищется экспоненциальным поиском, и целые
+//      куски серии переносятся без поэлементных сравнений.
+// В итоге отсортированный массив сортируется за n - 1 сравнение, почти
+// отсортированный -- почти за O(n), а на случайных данных остаётся
+// O(n log n) в худшем случае.
+
+// Массивы короче этого сортируются бинарными вставками целиком.
+constexpr size_t TIMSORT_MIN_MERGE = 64;
+
+// Сколько элементов подряд должно прийти из одной серии, чтобы слияние
+// перешло в режим галопа.
+constexpr size_t TIMSORT_MIN_GALLOP = 7;
+
+// Позиция в отсортированном a, куда можно вставить key левее всех равных ему
+// элементов (т.е. количество элементов меньше key). Поиск начинается с
+// позиции hint и идёт от неё экспоненциальными шагами, поэтому стоит
+// O(log d), где d -- расстояние от hint до ответа.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+size_t gallopLeft(const T& key, std::span<const T> a, size_t hint) {
+    // Ищем lastOfs < ofs, такие что a[lastOfs] < key <= a[ofs]
+    // (a[-1] считаем минус бесконечностью, a[size] -- плюс бесконечностью).
+    ptrdiff_t lastOfs = 0;
+    ptrdiff_t ofs = 1;
+    const ptrdiff_t h = static_cast<ptrdiff_t>(hint);
+
+    if (a[hint] < key) {
+        const ptrdiff_t maxOfs = static_cast<ptrdiff_t>(a.size()) - h;
+        while (ofs < maxOfs && a[h + ofs] < key) {
+            lastOfs = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        ofs = std::min(ofs, maxOfs);
+        lastOfs += h;
+        ofs += h;
+    } else {
+        const ptrdiff_t maxOfs = h + 1;
+        while (ofs < maxOfs && !(a[h - ofs] < key)) {
+            lastOfs = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        ofs = std::min(ofs, maxOfs);
+        ptrdiff_t tmp = lastOfs;
+        lastOfs = h - ofs;
+        ofs = h - tmp;
+    }
+
+    // Ответ в (lastOfs; ofs], досматриваем двоичным поиском.
+    lastOfs++;
+    while (lastOfs < ofs) {
+        ptrdiff_t m = lastOfs + (ofs - lastOfs) / 2;
+        if (a[m] < key) {
+            lastOfs = m + 1;
+        } else {
+            ofs = m;
+        }
+    }
+    return static_cast<size_t>(ofs);
+}
+
+// То же, что gallopLeft, но правее всех равных key элементов (т.е. количество
+// элементов не больше key).
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+size_t gallopRight(const T& key, std::span<const T> a, size_t hint) {
+    // Ищем lastOfs < ofs, такие что a[lastOfs] <= key < a[ofs].
+    ptrdiff_t lastOfs = 0;
+    ptrdiff_t ofs = 1;
+    const ptrdiff_t h = static_cast<ptrdiff_t>(hint);
+
+    if (key < a[hint]) {
+        const ptrdiff_t maxOfs = h + 1;
+        while (ofs < maxOfs && key < a[h - ofs]) {
+            lastOfs = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        ofs = std::min(ofs, maxOfs);
+        ptrdiff_t tmp = lastOfs;
+        lastOfs = h - ofs;
+        ofs = h - tmp;
+    } else {
+        const ptrdiff_t maxOfs = static_cast<ptrdiff_t>(a.size()) - h;
+        while (ofs < maxOfs && !(key < a[h + ofs])) {
+            lastOfs = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        ofs = std::min(ofs, maxOfs);
+        lastOfs += h;
+        ofs += h;
+    }
+
+    lastOfs++;
+    while (lastOfs < ofs) {
+        ptrdiff_t m = lastOfs + (ofs - lastOfs) / 2;
+        if (key < a[m]) {
+            ofs = m;
+        } else {
+            lastOfs = m + 1;
+        }
+    }
+    return static_cast<size_t>(ofs);
+}
+
+// Состояние одной адаптивной сортировки: массив, стек серий, буфер для
+// слияний и текущий порог галопа.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+class TimSorter {
+public:
+    explicit TimSorter(std::span<T> arr) : arr_(arr) {}
+
+    void sort() {
+        const size_t n = arr_.size();
+        if (n < 2) {
+            return;
+        }
+
+        if (n < TIMSORT_MIN_MERGE) {
+            binaryInsertionSort(arr_, countRunAndMakeAscending(0));
+            return;
+        }
+
+        const size_t minRun = minRunLength(n);
+        for (size_t begin = 0; begin < n;) {
+            size_t length = countRunAndMakeAscending(begin);
+
+            // Короткую серию дополняем до minRun (или до конца массива).
+            if (length < minRun) {
+                size_t forced = std::min(minRun, n - begin);
+                binaryInsertionSort(arr_.subspan(begin, forced), length);
+                length = forced;
+            }
+
+            runs_.push_back({begin, length});
+            mergeCollapse();
+            begin += length;
+        }
+        mergeForceCollapse();
+    }
+
+private:
+    struct Run {
+        size_t begin;
+        size_t length;
+    };
+
+    // Минимальная длина серии: число из [32; 64], такое что n / minRun
+    // равно степени двойки или чуть меньше её -- тогда последние слияния
+    // получаются сбалансированными.
+    static size_t minRunLength(size_t n) {
+        size_t r = 0;
+        while (n >= TIMSORT_MIN_MERGE) {
+            r |= n & 1;
+            n >>= 1;
+        }
+        return n + r;
+    }
+
+    // Длина серии, начинающейся с begin. Строго убывающая серия разворачивается.
+    size_t countRunAndMakeAscending(size_t begin) {
+        const size_t n = arr_.size();
+        size_t end = begin + 1;
+        if (end == n) {
+            return 1;
+        }
+
+        if (arr_[end] < arr_[begin]) {
+            end++;
+            while (end < n && arr_[end] < arr_[end - 1]) {
+                end++;
+            }
+            std::reverse(arr_.begin() + begin, arr_.begin() + end);
+        } else {
+            end++;
+            while (end < n && !(arr_[end] < arr_[end - 1])) {
+                end++;
+            }
+        }
+        return end - begin;
+    }
+
+    // Сортировка бинарными вставками массива, начало которого длины sorted
+    // уже отсортировано. Место вставки ищется правее равных -- это сохраняет
+    // устойчивость.
+    static void binaryInsertionSort(std::span<T> arr, size_t sorted) {
+        for (size_t i = std::max<size_t>(sorted, 1); i < arr.size(); i++) {
+            T value = std::move(arr[i]);
+            auto pos = std::upper_bound(arr.begin(), arr.begin() + i, value);
+            std::move_backward(pos, arr.begin() + i, arr.begin() + i + 1);
+            *pos = std::move(value);
+        }
+    }
+
+    // Поддерживаем для верхних серий стека X, Y, Z (Z -- верхняя) условия
+    // X > Y + Z и Y > Z, сливая Y с меньшей из соседних, пока они нарушены.
+    // Условие проверяется и на одну серию глубже: без этого в редких случаях
+    // инвариант нарушается ниже вершины стека.
+    void mergeCollapse() {
+        while (runs_.size() > 1) {
+            size_t k = runs_.size() - 2;
+            if ((k > 0 && runs_[k - 1].length <= runs_[k].length + runs_[k + 1].length)
+                || (k > 1 && runs_[k - 2].length <= runs_[k - 1].length + runs_[k].length)) {
+                if (runs_[k - 1].length < runs_[k + 1].length) {
+                    k--;
+                }
+            } else if (runs_[k].length > runs_[k + 1].length) {
+                break;
+            }
+            mergeAt(k);
+        }
+    }
+
+    // Сливаем все оставшиеся серии.
+    void mergeForceCollapse() {
+        while (runs_.size() > 1) {
+            size_t k = runs_.size() - 2;
+            if (k > 0 && runs_[k - 1].length < runs_[k + 1].length) {
+                k--;
+            }
+            mergeAt(k);
+        }
+    }
+
+    // Сливаем серии k и k + 1 стека.
+    void mergeAt(size_t k) {
+        size_t begin1 = runs_[k].begin;
+        size_t length1 = runs_[k].length;
+        const size_t begin2 = runs_[k + 1].begin;
+        size_t length2 = runs_[k + 1].length;
+
+        runs_[k].length += length2;
+        runs_.erase(runs_.begin() + k + 1);
+
+        // Начало первой серии, которое не больше первого элемента второй,
+        // и конец второй, который не меньше последнего элемента первой, уже
+        // стоят на своих местах -- сливать нужно только середину.
+        std::span<const T> run1(arr_.data() + begin1, length1);
+        size_t skip = gallopRight(arr_[begin2], run1, 0);
+        begin1 += skip;
+        length1 -= skip;
+        if (length1 == 0) {
+            return;
+        }
+
+        std::span<const T> run2(arr_.data() + begin2, length2);
+        length2 = gallopLeft(arr_[begin1 + length1 - 1], run2, length2 - 1);
+        if (length2 == 0) {
+            return;
+        }
+
+        // Во временный буфер копируется меньшая из серий.
+        if (length1 <= length2) {
+            mergeLow(begin1, length1, length2);
+        } else {
+            mergeHigh(begin1, length1, length2);
+        }
+    }
+
+    // Слияние слева направо: первая серия (более короткая) переносится в
+    // буфер, и результат пишется на её место.
+    void mergeLow(size_t begin1, size_t length1, size_t length2) {
+        tmp_.resize(std::max(tmp_.size(), length1));
+        std::move(arr_.begin() + begin1, arr_.begin() + begin1 + length1, tmp_.begin());
+
+        std::span<T> a = arr_;
+        std::span<T> left(tmp_.data(), length1);
+        size_t i = 0;
+        size_t j = begin1 + length1;
+        const size_t end2 = j + length2;
+        size_t dest = begin1;
+
+        while (i < length1 && j < end2) {
+            // Обычное слияние, пока одна из серий не начнёт выигрывать подряд.
+            size_t count1 = 0;
+            size_t count2 = 0;
+            while (i < length1 && j < end2 && count1 < minGallop_ && count2 < minGallop_) {
+                if (a[j] < left[i]) {
+                    a[dest++] = std::move(a[j++]);
+                    count2++;
+                    count1 = 0;
+                } else {
+                    a[dest++] = std::move(left[i++]);
+                    count1++;
+                    count2 = 0;
+                }
+            }
+
+            // Галоп: переносим целые куски, пока они достаточно длинные.
+            while (i < length1 && j < end2) {
+                count1 = gallopRight(a[j], std::span<const T>(left.data() + i, length1 - i), 0);
+                std::move(left.begin() + i, left.begin() + i + count1, a.begin() + dest);
+                dest += count1;
+                i += count1;
+                if (i == length1) {
+                    break;
+                }
+                a[dest++] = std::move(a[j++]);
+                if (j == end2) {
+                    break;
+                }
+
+                count2 = gallopLeft(left[i], std::span<const T>(a.data() + j, end2 - j), 0);
+                std::move(a.begin() + j, a.begin() + j + count2, a.begin() + dest);
+                dest += count2;
+                j += count2;
+                if (j == end2) {
+                    break;
+                }
+                a[dest++] = std::move(left[i++]);
+
+                if (minGallop_ > 1) {
+                    minGallop_--;
+                }
+                if (count1 < TIMSORT_MIN_GALLOP && count2 < TIMSORT_MIN_GALLOP) {
+                    // Галоп перестал окупаться -- штрафуем переход в него.
+                    minGallop_ += 2;
+                    break;
+                }
+            }
+        }
+
+        // Остаток второй серии уже на месте, дописываем остаток первой.
+        std::move(left.begin() + i, left.end(), a.begin() + dest);
+    }
+
+    // Слияние справа налево: вторая серия (более короткая) переносится в
+    // буфер, и результат пишется с конца.
+    void mergeHigh(size_t begin1, size_t length1, size_t length2) {
+        const size_t begin2 = begin1 + length1;
+        tmp_.resize(std::max(tmp_.size(), length2));
+        std::move(arr_.begin() + begin2, arr_.begin() + begin2 + length2, tmp_.begin());
+
+        std::span<T> a = arr_;
+        std::span<T> right(tmp_.data(), length2);
+
+        // Ещё не слитые части: a[begin1; j) и right[0; i), результат пишется
+        // левее dest.
+        size_t i = length2;
+        size_t j = begin2;
+        size_t dest = begin2 + length2;
+
+        while (i > 0 && j > begin1) {
+            size_t count1 = 0;
+            size_t count2 = 0;
+            while (i > 0 && j > begin1 && count1 < minGallop_ && count2 < minGallop_) {
+                if (right[i - 1] < a[j - 1]) {
+                    a[--dest] = std::move(a[--j]);
+                    count1++;
+                    count2 = 0;
+                } else {
+                    a[--dest] = std::move(right[--i]);
+                    count2++;
+                    count1 = 0;
+                }
+            }
+
+            while (i > 0 && j > begin1) {
+                // Элементы первой серии, которые больше right[i - 1].
+                std::span<const T> run1(a.data() + begin1, j - begin1);
+                count1 = run1.size() - gallopRight(right[i - 1], run1, run1.size() - 1);
+                std::move_backward(a.begin() + j - count1, a.begin() + j, a.begin() + dest);
+                dest -= count1;
+                j -= count1;
+                if (j == begin1) {
+                    break;
+                }
+                a[--dest] = std::move(right[--i]);
+                if (i == 0) {
+                    break;
+                }
+
+                // Элементы второй серии, которые не меньше a[j - 1].
+                std::span<const T> run2(right.data(), i);
+                count2 = i - gallopLeft(a[j - 1], run2, i - 1);
+                std::move_backward(right.begin() + i - count2, right.begin() + i, a.begin() + dest);
+                dest -= count2;
+                i -= count2;
+                if (i == 0) {
+                    break;
+                }
+                a[--dest] = std::move(a[--j]);
+
+                if (minGallop_ > 1) {
+                    minGallop_--;
+                }
+                if (count1 < TIMSORT_MIN_GALLOP && count2 < TIMSORT_MIN_GALLOP) {
+                    minGallop_ += 2;
+                    break;
+                }
+            }
+        }
+
+        // Остаток первой серии уже на месте, дописываем остаток второй.
+        std::move(right.begin(), right.begin() + i, a.begin() + begin1);
+    }
+
+    std::span<T> arr_;
+    std::vector<Run> runs_;
+    std::vector<T> tmp_;
+    size_t minGallop_ = TIMSORT_MIN_GALLOP;
+};
+
+// Адаптивная (естественная) сортировка слиянием. Устойчива.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void timsort(std::span<T> arr) {
+    TimSorter<T>(arr).sort();
+}
+
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void timsort(std::vector<T>& arr) {
+    timsort(std::span<T>(arr));
+}
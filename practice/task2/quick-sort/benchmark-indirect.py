@@ -0,0 +1,38 @@
+import random
+import statistics
+import subprocess
+import sys
+
+# Сравнение прямой и косвенной (--indirect) сортировки тяжёлых элементов --
+# 256-байтных записей (--type record) -- и, для сравнения, обычных int'ов.
+# При прямой сортировке каждое перемещение записи копирует 256 байт, при
+# косвенной перемещаются 16-байтные записи "префикс + указатель", а сами
+# элементы переставляются один раз в конце.
+#
+# Запуск: python3 benchmark-indirect.py [n], программа должна быть собрана с -O2.
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 200000
+repeats = 5
+modes = ["classic", "intro", "block", "threeway"]
+
+input_data = (f"{n} " + " ".join(str(random.randint(-10**9, 10**9)) for _ in range(n))).encode()
+
+
+def measure(args):
+    times = []
+    for _ in range(repeats):
+        proc = subprocess.run(["./a.out", "--benchmark"] + args, input=input_data, capture_output=True)
+        if proc.returncode != 0:
+            print(f"\nОшибка выполнения: {proc.stderr.decode()}")
+            exit(1)
+        times.append(int(proc.stdout.decode().strip()))
+    return statistics.median(times)
+
+
+print(f"n = {n}, время сортировки в мкс (медиана из {repeats})")
+print(f"{'тип':<8} {'вариант':<10}{'прямая':>12}{'косвенная':>12}")
+for element_type in ["record", "i32"]:
+    for mode in modes:
+        direct = measure(["--type", element_type, "--mode", mode])
+        indirect = measure(["--type", element_type, "--mode", mode, "--indirect"])
+        print(f"{element_type:<8} {mode:<10}{direct:>12}{indirect:>12}")
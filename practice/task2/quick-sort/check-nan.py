@@ -0,0 +1,37 @@
+import math
+import random
+import subprocess
+import sys
+
+# Проверка, что сортировки не теряют NaN: массивы чисел double с NaN
+# сортируются через --binary всеми вариантами, и результат должен быть
+# перестановкой входа (с тем же количеством NaN). Раньше векторная сеть
+# сортировки в базовом случае заменяла NaN на +inf из дополнения.
+#
+# Запуск: python3 check-nan.py (нужны ./a.out и ./binconv.out).
+
+random.seed(11)
+modes = ["classic", "intro", "block", "threeway"]
+
+
+def key(values):
+    return sum(math.isnan(x) for x in values), sorted(x for x in values if not math.isnan(x))
+
+
+for trial in range(30):
+    n = random.choice([5, 17, 40, 64, 100, 1000])
+    values = [round(random.uniform(-100, 100), 2) for _ in range(n)]
+    for _ in range(random.randint(1, 3)):
+        values[random.randrange(n)] = math.nan
+    text = f"{n} " + " ".join(map(str, values))
+
+    for mode in modes:
+        subprocess.run(["./binconv.out", "--to-binary", "nan.bin", "--type", "f64"], input=text.encode(), check=True)
+        subprocess.run(["./a.out", "--mode", mode, "--binary", "nan.bin"], check=True)
+        result = subprocess.run(["./binconv.out", "--to-text", "nan.bin"], capture_output=True, check=True)
+        sorted_values = [float(x) for x in result.stdout.decode().split()[1:]]
+        if key(sorted_values) != key(values):
+            print(f"--mode {mode}: результат не является перестановкой входа (n = {n})")
+            sys.exit(1)
+
+print("ok: NaN сохраняются во всех вариантах")
@@ -1,96 +1,207 @@
+#include "../../common/binary-array.hpp"
+#include "../../common/fast-io.hpp"
+#include "../../common/indirect-sort.hpp"
+#include "quicksort.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <exception>
 #include <iostream>
 #include <span>
+#include <string>
+#include <thread>
 #include <vector>
-#include <chrono>
-
-// Быстрая сортировка является алгоритмом, использующий операцию сравнения,
-// поэтому мы наложим на шаблон ограничение, что он должен перегружать операторы сравнения
-template<class T>
-requires requires (const T& a, const T& b) {
-   { a < b } -> std::convertible_to<bool>;
-   { a > b } -> std::convertible_to<bool>;
-}
-void quicksort(std::span<T> arr) {
-    // В быстрой сортировке мы рекурсивно разбиваем массив на две части.
-    // Условием выхода из рекурсии будет момент, когда массив станет пустым.
-    if (arr.size() <= 1) {
-        return;
+
+// Тяжёлый элемент для --type record: 256-байтная запись, упорядоченная по
+// ключу. Остальные байты записи заполняются из ключа, так что после сортировки
+// видно, переместилась ли запись целиком.
+struct Record {
+    int key = 0;
+    std::array<unsigned char, 252> payload{};
+
+    Record() = default;
+
+    explicit Record(int k) : key(k) {
+        payload.fill(static_cast<unsigned char>(k));
     }
 
-    // В качестве опорного элемента выбираем средний элемент массива
-    T pivot = arr[arr.size() / 2];
+    bool intact() const {
+        return std::all_of(payload.begin(), payload.end(), [this](unsigned char c) {
+            return c == static_cast<unsigned char>(key);
+        });
+    }
 
-    size_t left = 0;
-    size_t right = arr.size() - 1;
+    friend bool operator<(const Record& a, const Record& b) {
+        return a.key < b.key;
+    }
 
-    while (left <= right) {
-        // Мы начинаем идти слева направо до момента, пока элемент не станет меньше опорного.
-        while (arr[left] < pivot) {
-            ++left;
-        }
+    friend bool operator>(const Record& a, const Record& b) {
+        return a.key > b.key;
+    }
+};
 
-        // Потом мы идём справа налево до момента, пока элемент не станет больше опорного.
-        while (arr[right] > pivot) {
-            --right;
-        }
+// Префикс записи для косвенной сортировки -- префикс её ключа.
+uint64_t indirectKeyPrefix(const Record& record) {
+    return indirectKeyPrefix(record.key);
+}
 
-        // Если левый индекс меньше правого, то это значит, что необходимо поменять
-        // местами левый и правый элементы.
-        if (left <= right) {
-            std::swap(arr[left], arr[right]);
-            ++left;
-            --right;
-        }
+// Считываем числа, сортируем их как элементы типа T (int или записи с этими
+// ключами) функцией sort и выводим ключи.
+// Если timings_mode включён, в stderr выводится время разбора ввода, сортировки и вывода.
+template<class T, class Sort>
+int run(Sort& sort, bool benchmark_mode, bool timings_mode) {
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
 
-        // Мы это делаем до тех пор, пока левый индекс не станет больше правого.
+    // считываем массив
+    std::vector<T> arr;
+    try {
+        timings.parse = measureMicroseconds([&]() {
+            std::vector<int> numbers = input.readArray<int>();
+            if constexpr (std::same_as<T, int>) {
+                arr = std::move(numbers);
+            } else {
+                arr.reserve(numbers.size());
+                for (int number : numbers) {
+                    arr.emplace_back(number);
+                }
+            }
+        });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
-    // Если мы сдвинулись вправо хотя бы на один элемент,
-    // мы запускаем рекурсию для левой части массива.
-    if (right > 0) {
-        quicksort(arr.subspan(0, right + 1));
+    // сортируем массив
+    timings.sort = measureMicroseconds([&]() { sort(std::span<T>(arr)); });
+
+    if constexpr (std::same_as<T, Record>) {
+        if (!std::all_of(arr.begin(), arr.end(), [](const Record& record) { return record.intact(); })) {
+            std::cerr << "record corrupted by sorting" << std::endl;
+            return 1;
+        }
     }
 
-    // Аналогично для правой части массива.
-    if (left < arr.size()) {
-        quicksort(arr.subspan(left));
+    if (benchmark_mode) {
+        output.write(timings.sort);
+        output.write('\n');
+    } else {
+        // выводим массив на экран
+        timings.write = measureMicroseconds([&]() {
+            if constexpr (std::same_as<T, int>) {
+                output.writeArray(std::span<const int>(arr));
+            } else {
+                for (const Record& record : arr) {
+                    output.write(record.key);
+                    output.write(' ');
+                }
+                output.write('\n');
+            }
+            output.flush();
+        });
     }
+
+    if (timings_mode) {
+        timings.report();
+    }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
     bool benchmark_mode = false;
-    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
-        benchmark_mode = true;
-    }
 
-    int n;  // кол-во элементов
-    std::cin >> n;
+    // --timings выводит в stderr время разбора ввода, сортировки и вывода
+    bool timings_mode = false;
+
+    // --binary FILE сортирует двоичный файл на месте вместо текстового ввода
+    std::string binary_path;
+
+    // --type i32 сортирует числа (по умолчанию), --type record -- 256-байтные
+    // записи с этими числами в качестве ключей (для сравнения с --indirect)
+    std::string type = "i32";
+
+    // --indirect сортирует косвенно: выбранный вариант упорядочивает компактные
+    // записи "префикс ключа + указатель на элемент", а сами элементы затем
+    // переставляются на свои места по одному разу (для тяжёлых элементов)
+    bool indirect_mode = false;
 
-    // указываем capacity = n, тем самым сразу аллоцировав место под n элеметов
-    std::vector<int> arr;
-    arr.reserve(n);
+    // --mode выбирает вариант сортировки:
+    // classic -- простая быстрая сортировка (по умолчанию),
+    // intro -- интроспективная сортировка с гарантией O(n log n),
+    // block -- она же с блочным разбиением без ветвлений,
+    // threeway -- она же с разбиением на три части (для входов с повторами),
+    // parallel -- параллельная сортировка на пуле потоков
+    std::string mode = "classic";
 
-    // заполняем массив
-    for (int i = 0; i < n; i++) {
-        int num;
-        std::cin >> num;
-        arr.push_back(num);
+    // количество потоков для --mode parallel задаётся флагом --threads,
+    // по умолчанию -- все ядра
+    size_t threads = std::thread::hardware_concurrency();
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--benchmark") {
+                benchmark_mode = true;
+            } else if (arg == "--timings") {
+                timings_mode = true;
+            } else if (arg == "--indirect") {
+                indirect_mode = true;
+            } else if (arg == "--binary" && i + 1 < argc) {
+                binary_path = argv[++i];
+            } else if (arg == "--mode" && i + 1 < argc) {
+                mode = argv[++i];
+            } else if (arg == "--type" && i + 1 < argc) {
+                type = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                threads = parseFlagValue(arg, argv[++i]);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
-    // сортируем массив
-    if (benchmark_mode) {
-        auto start = std::chrono::high_resolution_clock::now();
-        quicksort(std::span<int>(arr));
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        std::cout << duration.count() << std::endl;
-    } else {
-        quicksort(std::span<int>(arr));
+    // сортировка выбранным вариантом
+    auto sortDirect = [&mode, threads](auto arr) {
+        if (mode == "intro") {
+            quicksortIntro(arr);
+        } else if (mode == "block") {
+            quicksortBlock(arr);
+        } else if (mode == "threeway") {
+            quicksortThreeWay(arr);
+        } else if (mode == "parallel") {
+            quicksortParallel(arr, threads);
+        } else {
+            quicksort(arr);
+        }
+    };
 
-        // выводим массив на экран
-        for (int num : arr) {
-            std::cout << num << " ";
+    auto sort = [&sortDirect, indirect_mode](auto arr) {
+        if (indirect_mode) {
+            sortIndirect(arr, sortDirect);
+        } else {
+            sortDirect(arr);
         }
-        std::cout << std::endl;
+    };
+
+    if (mode != "classic" && mode != "intro" && mode != "block" && mode != "threeway"
+        && mode != "parallel") {
+        std::cerr << "Неизвестный вариант сортировки: " << mode << std::endl;
+        return 1;
+    }
+
+    if (!binary_path.empty()) {
+        return sortBinaryFile(binary_path, benchmark_mode, timings_mode, sort);
+    }
+
+    if (type == "i32") {
+        return run<int>(sort, benchmark_mode, timings_mode);
+    } else if (type == "record") {
+        return run<Record>(sort, benchmark_mode, timings_mode);
+    } else {
+        std::cerr << "Неизвестный тип: " << type << std::endl;
+        return 1;
     }
 }
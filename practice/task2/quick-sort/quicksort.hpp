@@ -0,0 +1,611 @@
+#pragma once
+
+#include "../../common/insertion-sort.hpp"
+#include "../../common/sorting-network.hpp"
+#include "../../common/work-stealing-pool.hpp"
+#include "../heap-sort/heapsort.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Быстрая сортировка является алгоритмом, использующий операцию сравнения,
+// поэтому мы наложим на шаблон ограничение, что он должен перегружать операторы сравнения
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void quicksort(std::span<T> arr) {
+    // В быстрой сортировке мы рекурсивно разбиваем массив на две части.
+    // Условием выхода из рекурсии будет момент, когда массив станет пустым.
+    if (arr.size() <= 1) {
+        return;
+    }
+
+    // В качестве опорного элемента выбираем средний элемент массива
+    T pivot = arr[arr.size() / 2];
+
+    size_t left = 0;
+    size_t right = arr.size() - 1;
+
+    while (left <= right) {
+        // Мы начинаем идти слева направо до момента, пока элемент не станет меньше опорного.
+        while (arr[left] < pivot) {
+            ++left;
+        }
+
+        // Потом мы идём справа налево до момента, пока элемент не станет больше опорного.
+        while (arr[right] > pivot) {
+            --right;
+        }
+
+        // Если левый индекс меньше правого, то это значит, что необходимо поменять
+        // местами левый и правый элементы.
+        if (left <= right) {
+            std::swap(arr[left], arr[right]);
+            ++left;
+            --right;
+        }
+
+        // Мы это делаем до тех пор, пока левый индекс не станет больше правого.
+    }
+
+    // Если мы сдвинулись вправо хотя бы на один элемент,
+    // мы запускаем рекурсию для левой части массива.
+    if (right > 0) {
+        quicksort(arr.subspan(0, right + 1));
+    }
+
+    // Аналогично для правой части массива.
+    if (left < arr.size()) {
+        quicksort(arr.subspan(left));
+    }
+}
+
+// Ниже -- "промышленный" вариант быстрой сортировки (интроспективная сортировка).
+// У простой версии выше три слабых места:
+//   1. опорный элемент -- средний, и на специально подобранных входах (например,
+//      "органной трубе" 1 2 3 ... 3 2 1) он раз за разом оказывается почти
+//      минимальным, и сортировка вырождается в O(n^2);
+//   2. рекурсия идёт в обе части, поэтому её глубина в худшем случае -- O(n);
+//   3. рекурсия доходит до массивов из одного элемента, где вызовы функций
+//      стоят дороже самой сортировки.
+// Поэтому здесь опорный элемент -- медиана трёх (а на больших массивах медиана
+// медиан трёх троек, "ниндзер" Тьюки), маленькие массивы досортировываются
+// вставками, рекурсия идёт только в меньшую часть (глубина не больше log n),
+// а если глубина разбиений всё же превысила 2 log n, массив досортировывается
+// пирамидальной сортировкой. Так худший случай -- O(n log n), а в среднем
+// скорость та же, что и у быстрой сортировки.
+
+// Массивы такого размера и меньше сортируются вставками.
+constexpr size_t QUICKSORT_INSERTION_THRESHOLD = 24;
+
+// Массивы такого размера и меньше досортировываются базовым случаем. Для
+// типов, у которых есть векторная сеть сортировки, он намного быстрее вставок,
+// поэтому и части до него дробятся реже.
+template<class T>
+constexpr size_t quicksortSmallThreshold() {
+    if constexpr (SortingNetworkType<T>) {
+        return SORTING_NETWORK_MAX;
+    }
+    return QUICKSORT_INSERTION_THRESHOLD;
+}
+
+// Начиная с такого размера опорный элемент выбирается как медиана медиан.
+constexpr size_t QUICKSORT_NINTHER_THRESHOLD = 128;
+
+// Результат разбиения: элементы [begin; end) уже стоят на своих местах
+// (опорный элемент и, возможно, равные ему), слева от begin -- не больше
+// них, справа от end -- не меньше.
+struct PartitionRange {
+    size_t begin;
+    size_t end;
+};
+
+// Упорядочиваем три элемента: arr[a] <= arr[b] <= arr[c].
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void sort3(std::span<T> arr, size_t a, size_t b, size_t c) {
+    if (arr[b] < arr[a]) {
+        std::swap(arr[a], arr[b]);
+    }
+    if (arr[c] < arr[b]) {
+        std::swap(arr[b], arr[c]);
+        if (arr[b] < arr[a]) {
+            std::swap(arr[a], arr[b]);
+        }
+    }
+}
+
+// Выбираем опорный элемент и ставим его в начало массива. Возвращает true,
+// если в выборке опорный элемент встретился повторно (равен соседу в последней
+// упорядоченной тройке) -- это признак того, что в массиве много равных ему
+// элементов.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+bool choosePivot(std::span<T> arr) {
+    const size_t n = arr.size();
+    const size_t mid = n / 2;
+
+    size_t lower = 0;
+    size_t upper = n - 1;
+    if (n >= QUICKSORT_NINTHER_THRESHOLD) {
+        // Медиана трёх медиан: по тройке из начала, середины и конца массива.
+        sort3(arr, 0, mid, n - 1);
+        sort3(arr, 1, mid - 1, n - 2);
+        sort3(arr, 2, mid + 1, n - 3);
+        sort3(arr, mid - 1, mid, mid + 1);
+        lower = mid - 1;
+        upper = mid + 1;
+    } else {
+        sort3(arr, 0, mid, n - 1);
+    }
+
+    // Тройка упорядочена, так что "не меньше соседа" значит "равен ему".
+    bool repeats = !(arr[lower] < arr[mid]) || !(arr[mid] < arr[upper]);
+    std::swap(arr[0], arr[mid]);
+    return repeats;
+}
+
+// Разбиение Хоара относительно опорного элемента arr[0]. Возвращает позицию,
+// на которую встал опорный элемент: слева от неё элементы не больше него,
+// справа -- не меньше. Оба указателя останавливаются на равных опорному
+// элементах, поэтому массив из одинаковых элементов делится пополам.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+size_t partitionAroundFirst(std::span<T> arr) {
+    const T pivot = arr[0];
+    size_t left = 0;
+    size_t right = arr.size();
+
+    while (true) {
+        do {
+            left++;
+        } while (left < arr.size() && arr[left] < pivot);
+
+        // arr[0] -- сам опорный элемент, на нём указатель гарантированно остановится.
+        do {
+            right--;
+        } while (pivot < arr[right]);
+
+        if (left >= right) {
+            break;
+        }
+        std::swap(arr[left], arr[right]);
+    }
+
+    std::swap(arr[0], arr[right]);
+    return right;
+}
+
+// Размер блока при блочном разбиении. Смещения внутри блока хранятся в
+// uint8_t, поэтому блок не больше 256 элементов, а 64 -- это баланс между
+// долей работы без ветвлений и размером буферов смещений (по кэш-линии).
+constexpr size_t QUICKSORT_BLOCK_SIZE = 64;
+
+// Блочное разбиение (BlockQuicksort, как в pdqsort) относительно значения
+// pivot. В разбиении Хоара каждый шаг внутренних циклов -- условный
+// переход, который на случайных данных предсказывается неверно примерно в
+// половине случаев. Здесь же сравнения вообще не управляют переходами:
+//   1. для блока из 64 элементов слева записываем подряд смещения тех, что
+//      должны уйти вправо (не меньше опорного), -- смещение пишется всегда,
+//      а счётчик увеличивается на результат сравнения (0 или 1);
+//   2. так же для блока справа записываем смещения элементов меньше опорного;
+//   3. меняем местами найденные пары элементов одним простым циклом;
+//   4. исчерпанный блок сдвигаем к середине и повторяем.
+// Остаток в середине (меньше трёх блоков) разбивается обычным способом.
+// Возвращает количество элементов меньше опорного -- они оказываются в начале
+// массива, а за ними идут не меньшие.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+size_t partitionBlockByValue(std::span<T> arr, const T& pivot) {
+    // Разбиваем [first; last), всё левее first уже меньше опорного,
+    // всё правее last -- не меньше.
+    size_t first = 0;
+    size_t last = arr.size();
+
+    uint8_t offsetsLeft[QUICKSORT_BLOCK_SIZE];
+    uint8_t offsetsRight[QUICKSORT_BLOCK_SIZE];
+    size_t countLeft = 0;
+    size_t countRight = 0;
+    size_t startLeft = 0;
+    size_t startRight = 0;
+
+    while (last - first > 2 * QUICKSORT_BLOCK_SIZE) {
+        if (countLeft == 0) {
+            startLeft = 0;
+            for (size_t i = 0; i < QUICKSORT_BLOCK_SIZE; i++) {
+                offsetsLeft[countLeft] = static_cast<uint8_t>(i);
+                countLeft += !(arr[first + i] < pivot);
+            }
+        }
+
+        if (countRight == 0) {
+            startRight = 0;
+            for (size_t i = 0; i < QUICKSORT_BLOCK_SIZE; i++) {
+                offsetsRight[countRight] = static_cast<uint8_t>(i);
+                countRight += arr[last - 1 - i] < pivot;
+            }
+        }
+
+        size_t count = std::min(countLeft, countRight);
+        for (size_t k = 0; k < count; k++) {
+            std::swap(arr[first + offsetsLeft[startLeft + k]], arr[last - 1 - offsetsRight[startRight + k]]);
+        }
+
+        countLeft -= count;
+        countRight -= count;
+        startLeft += count;
+        startRight += count;
+
+        if (countLeft == 0) {
+            first += QUICKSORT_BLOCK_SIZE;
+        }
+        if (countRight == 0) {
+            last -= QUICKSORT_BLOCK_SIZE;
+        }
+    }
+
+    // Разбиваем остаток. Если в одном из блоков остались неразобранные
+    // смещения, этот блок всё ещё лежит внутри [first; last), так что
+    // обычное разбиение его доделает.
+    while (true) {
+        while (first < last && arr[first] < pivot) {
+            first++;
+        }
+        while (first < last && !(arr[last - 1] < pivot)) {
+            last--;
+        }
+        if (first >= last) {
+            break;
+        }
+        std::swap(arr[first], arr[last - 1]);
+        first++;
+        last--;
+    }
+
+    return first;
+}
+
+// Блочное разбиение относительно опорного элемента arr[0]. Возвращает позицию,
+// на которую встал опорный элемент: слева от неё элементы меньше него,
+// справа -- не меньше.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+size_t partitionBlock(std::span<T> arr) {
+    const T pivot = arr[0];
+    size_t pivotIdx = partitionBlockByValue(arr.subspan(1), pivot);
+    std::swap(arr[0], arr[pivotIdx]);
+    return pivotIdx;
+}
+
+// Трёхпутевое разбиение ("толстый" опорный элемент, разбиение Дейкстры)
+// относительно arr[0]. Массив делится на три части: меньше опорного, равные
+// ему и больше него. Равные элементы уже стоят на своих местах, и рекурсия в
+// них не заходит, так что массив из k различных значений сортируется за
+// O(n log k), а массив из одинаковых -- за один проход.
+// Возвращает границы части из равных опорному элементов.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+PartitionRange partitionThreeWay(std::span<T> arr) {
+    const T pivot = arr[0];
+
+    // [0; less) -- меньше опорного, [less; i) -- равны ему,
+    // [i; greater) -- ещё не просмотрены, [greater; n) -- больше опорного.
+    size_t less = 0;
+    size_t i = 1;
+    size_t greater = arr.size();
+
+    while (i < greater) {
+        if (arr[i] < pivot) {
+            std::swap(arr[less], arr[i]);
+            less++;
+            i++;
+        } else if (pivot < arr[i]) {
+            greater--;
+            std::swap(arr[i], arr[greater]);
+        } else {
+            i++;
+        }
+    }
+
+    return {less, greater};
+}
+
+// Основной цикл интроспективной сортировки. depthLimit -- сколько ещё
+// разбиений можно сделать, прежде чем перейти на пирамидальную сортировку,
+// partition -- функция разбиения относительно опорного элемента arr[0].
+// Если опорный элемент повторился в выборке, вместо partition массив
+// разбивается на три части, и равные опорному элементы больше не трогаются.
+template<class T, class Partition>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void introsortLoop(std::span<T> arr, size_t depthLimit, Partition partition) {
+    while (arr.size() > quicksortSmallThreshold<T>()) {
+        if (depthLimit == 0) {
+            heapsort(arr);
+            return;
+        }
+        depthLimit--;
+
+        PartitionRange equal = choosePivot(arr) ? partitionThreeWay(arr) : partition(arr);
+
+        std::span<T> left = arr.first(equal.begin);
+        std::span<T> right = arr.subspan(equal.end);
+
+        // Рекурсивно сортируем меньшую часть, а большую -- на следующей итерации
+        // цикла. Меньшая часть хотя бы вдвое меньше массива, так что глубина
+        // рекурсии не превысит log n.
+        if (left.size() < right.size()) {
+            introsortLoop(left, depthLimit, partition);
+            arr = right;
+        } else {
+            introsortLoop(right, depthLimit, partition);
+            arr = left;
+        }
+    }
+
+    smallSort(arr);
+}
+
+// Интроспективная сортировка: гарантированное O(n log n) в худшем случае.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void quicksortIntro(std::span<T> arr) {
+    if (arr.size() <= 1) {
+        return;
+    }
+    introsortLoop(arr, 2 * (std::bit_width(arr.size()) - 1), [](std::span<T> part) {
+        size_t pivotIdx = partitionAroundFirst(part);
+        return PartitionRange{pivotIdx, pivotIdx + 1};
+    });
+}
+
+// Интроспективная сортировка с блочным разбиением без ветвлений.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void quicksortBlock(std::span<T> arr) {
+    if (arr.size() <= 1) {
+        return;
+    }
+    introsortLoop(arr, 2 * (std::bit_width(arr.size()) - 1), [](std::span<T> part) {
+        size_t pivotIdx = partitionBlock(part);
+        return PartitionRange{pivotIdx, pivotIdx + 1};
+    });
+}
+
+// Интроспективная сортировка, которая всегда разбивает массив на три части.
+// На входах с небольшим числом различных значений (коды состояний, категории)
+// она быстрее остальных вариантов.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void quicksortThreeWay(std::span<T> arr) {
+    if (arr.size() <= 1) {
+        return;
+    }
+    introsortLoop(arr, 2 * (std::bit_width(arr.size()) - 1), [](std::span<T> part) {
+        return partitionThreeWay(part);
+    });
+}
+
+// Параллельная быстрая сортировка на пуле потоков с перехватом задач.
+// После разбиения меньшая часть отдаётся пулу отдельной задачей, а большую
+// поток сортирует сам; свободные потоки перехватывают отданные задачи.
+// Одного этого мало: первое разбиение всего массива -- это O(n) работы, во
+// время которой остальные потоки простаивают, а их ещё не скоро станет больше
+// двух. Поэтому большие массивы и разбиваются параллельно.
+
+// Массивы такого размера и меньше сортируются одним потоком: дробить их
+// дальше на задачи дороже, чем отсортировать.
+constexpr size_t QUICKSORT_PARALLEL_GRAIN = 1 << 14;
+
+// Столько элементов (не меньше) разбивает каждый поток при параллельном
+// разбиении.
+constexpr size_t QUICKSORT_PARALLEL_PARTITION_GRAIN = 1 << 17;
+
+// Параллельное разбиение относительно значения pivot. Возвращает количество
+// элементов меньше опорного -- они оказываются в начале массива.
+//   1. Массив делится на куски, и каждый поток разбивает свой кусок блочным
+//      разбиением. Теперь мы знаем less -- сколько всего элементов меньше
+//      опорного, т.е. где должна пройти граница.
+//   2. Левее границы остались "чужие" элементы (не меньше опорного) -- правые
+//      части кусков, а правее неё столько же чужих элементов меньше
+//      опорного -- левые части кусков. Оба множества -- это несколько
+//      отрезков, и k-й чужой элемент слева меняется местами с k-м чужим
+//      элементом справа; обмены тоже делятся между потоками поровну.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+size_t partitionParallel(std::span<T> arr, const T& pivot, WorkStealingPool& pool) {
+    const size_t n = arr.size();
+    const size_t chunks = std::clamp<size_t>(n / QUICKSORT_PARALLEL_PARTITION_GRAIN, 1, pool.size());
+    if (chunks == 1) {
+        return partitionBlockByValue(arr, pivot);
+    }
+
+    auto chunkBegin = [n, chunks](size_t c) { return c * n / chunks; };
+
+    // Границы внутри кусков (абсолютные позиции).
+    std::vector<size_t> splits(chunks);
+    {
+        TaskGroup group(pool);
+        for (size_t c = 0; c < chunks; c++) {
+            group.run([&, c]() {
+                const size_t begin = chunkBegin(c);
+                const size_t end = chunkBegin(c + 1);
+                splits[c] = begin + partitionBlockByValue(arr.subspan(begin, end - begin), pivot);
+            });
+        }
+        group.wait();
+    }
+
+    size_t less = 0;
+    for (size_t c = 0; c < chunks; c++) {
+        less += splits[c] - chunkBegin(c);
+    }
+
+    // Отрезки чужих элементов слева и справа от границы.
+    struct Interval {
+        size_t begin;
+        size_t end;
+    };
+    std::vector<Interval> wrongLeft;
+    std::vector<Interval> wrongRight;
+    size_t wrong = 0;
+    for (size_t c = 0; c < chunks; c++) {
+        const size_t end = std::min(chunkBegin(c + 1), less);
+        if (splits[c] < end) {
+            wrongLeft.push_back({splits[c], end});
+            wrong += end - splits[c];
+        }
+        const size_t begin = std::max(chunkBegin(c), less);
+        if (begin < splits[c]) {
+            wrongRight.push_back({begin, splits[c]});
+        }
+    }
+
+    // Позиция k-го чужого элемента: номер отрезка и позиция в массиве.
+    auto locate = [](const std::vector<Interval>& intervals, size_t k) {
+        size_t i = 0;
+        while (k >= intervals[i].end - intervals[i].begin) {
+            k -= intervals[i].end - intervals[i].begin;
+            i++;
+        }
+        return std::pair{i, intervals[i].begin + k};
+    };
+
+    const size_t parts = std::clamp<size_t>(wrong / QUICKSORT_PARALLEL_GRAIN, 1, chunks);
+    TaskGroup group(pool);
+    for (size_t p = 0; p < parts; p++) {
+        group.run([&, p]() {
+            const size_t from = p * wrong / parts;
+            size_t remaining = (p + 1) * wrong / parts - from;
+            if (remaining == 0) {
+                return;
+            }
+
+            auto [leftIdx, leftPos] = locate(wrongLeft, from);
+            auto [rightIdx, rightPos] = locate(wrongRight, from);
+            while (true) {
+                // Меняем местами сразу целые куски отрезков.
+                size_t count = std::min({remaining, wrongLeft[leftIdx].end - leftPos, wrongRight[rightIdx].end - rightPos});
+                std::swap_ranges(arr.begin() + leftPos, arr.begin() + leftPos + count, arr.begin() + rightPos);
+                remaining -= count;
+                if (remaining == 0) {
+                    break;
+                }
+
+                leftPos += count;
+                if (leftPos == wrongLeft[leftIdx].end) {
+                    leftPos = wrongLeft[++leftIdx].begin;
+                }
+                rightPos += count;
+                if (rightPos == wrongRight[rightIdx].end) {
+                    rightPos = wrongRight[++rightIdx].begin;
+                }
+            }
+        });
+    }
+    group.wait();
+
+    return less;
+}
+
+// Задача параллельной сортировки: сортирует arr, отдавая меньшие части после
+// разбиений в group.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void parallelQuicksortTask(std::span<T> arr, size_t depthLimit, WorkStealingPool& pool, TaskGroup& group) {
+    while (arr.size() > QUICKSORT_PARALLEL_GRAIN) {
+        if (depthLimit == 0) {
+            heapsort(arr);
+            return;
+        }
+        depthLimit--;
+
+        PartitionRange equal;
+        if (choosePivot(arr)) {
+            equal = partitionThreeWay(arr);
+        } else {
+            const T pivot = arr[0];
+            size_t pivotIdx = partitionParallel(arr.subspan(1), pivot, pool);
+            std::swap(arr[0], arr[pivotIdx]);
+            equal = {pivotIdx, pivotIdx + 1};
+        }
+
+        std::span<T> left = arr.first(equal.begin);
+        std::span<T> right = arr.subspan(equal.end);
+        if (left.size() > right.size()) {
+            std::swap(left, right);
+        }
+
+        group.run([left, depthLimit, &pool, &group]() {
+            parallelQuicksortTask(left, depthLimit, pool, group);
+        });
+        arr = right;
+    }
+
+    introsortLoop(arr, depthLimit, [](std::span<T> part) {
+        size_t pivotIdx = partitionBlock(part);
+        return PartitionRange{pivotIdx, pivotIdx + 1};
+    });
+}
+
+// Параллельная быстрая сортировка в threadCount потоков (вместе с вызвавшим).
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void quicksortParallel(std::span<T> arr, size_t threadCount = std::thread::hardware_concurrency()) {
+    if (threadCount <= 1 || arr.size() <= QUICKSORT_PARALLEL_GRAIN) {
+        quicksortBlock(arr);
+        return;
+    }
+
+    WorkStealingPool pool(threadCount);
+    TaskGroup group(pool);
+    parallelQuicksortTask(arr, 2 * (std::bit_width(arr.size()) - 1), pool, group);
+    group.wait();
+}
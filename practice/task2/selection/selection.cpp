@@ -0,0 +1,93 @@
+#include "../../common/fast-io.hpp"
+#include "selection.hpp"
+
+#include <exception>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    bool benchmark_mode = false;
+
+    // --timings выводит в stderr время разбора ввода, выбора и вывода
+    bool timings_mode = false;
+
+    // --mode выбирает операцию:
+    // top -- k наименьших элементов по возрастанию (по умолчанию),
+    // nth -- k-й по возрастанию элемент (считая от нуля)
+    std::string mode = "top";
+
+    // k задаётся флагом --k
+    size_t k = 10;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--benchmark") {
+                benchmark_mode = true;
+            } else if (arg == "--timings") {
+                timings_mode = true;
+            } else if (arg == "--mode" && i + 1 < argc) {
+                mode = argv[++i];
+            } else if (arg == "--k" && i + 1 < argc) {
+                k = parseFlagValue(arg, argv[++i]);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (mode != "top" && mode != "nth") {
+        std::cerr << "Неизвестная операция: " << mode << std::endl;
+        return 1;
+    }
+
+    FastInput input;
+    FastOutput output;
+    PhaseTimings timings;
+
+    // считываем массив
+    std::vector<int> arr;
+    try {
+        timings.parse = measureMicroseconds([&]() { arr = input.readArray<int>(); });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (mode == "nth" && k >= arr.size()) {
+        std::cerr << "k должно быть меньше размера массива: " << k << std::endl;
+        return 1;
+    }
+
+    // выбираем элементы
+    timings.sort = measureMicroseconds([&]() {
+        if (mode == "top") {
+            partialSort(std::span<int>(arr), k);
+        } else {
+            nthElement(std::span<int>(arr), k);
+        }
+    });
+
+    if (benchmark_mode) {
+        output.write(timings.sort);
+        output.write('\n');
+    } else {
+        // выводим результат на экран
+        timings.write = measureMicroseconds([&]() {
+            if (mode == "top") {
+                output.writeArray(std::span<const int>(arr).first(std::min(k, arr.size())));
+            } else {
+                output.write(arr[k]);
+                output.write('\n');
+            }
+            output.flush();
+        });
+    }
+
+    if (timings_mode) {
+        timings.report();
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../heap-sort/heapsort.hpp"
+#include "../quick-sort/quicksort.hpp"
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+// Частичная сортировка: после вызова arr[0..k) -- k наименьших элементов
+// массива по возрастанию, остальные элементы -- в произвольном порядке.
+// Полная сортировка стоит O(n log n), а здесь достаточно кучи из k элементов:
+// в ней держим k наименьших из просмотренных, а в корне -- наибольший из них.
+// Очередной элемент либо не меньше корня и пропускается за одно сравнение,
+// либо заменяет корень и просеивается за O(log k). Итого O(n log k), и кучи
+// из k элементов (k обычно мало -- таблица лидеров, отсечка по процентилю)
+// целиком лежат в кэше.
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void partialSort(std::span<T> arr, size_t k) {
+    k = std::min(k, arr.size());
+    if (k == 0) {
+        return;
+    }
+
+    std::span<T> heap = arr.first(k);
+    daryHeapify<HEAPSORT_ARITY>(heap);
+
+    for (size_t i = k; i < arr.size(); i++) {
+        if (arr[i] < heap[0]) {
+            T value = std::move(arr[i]);
+            arr[i] = std::move(heap[0]);
+            daryHeapSiftDown<HEAPSORT_ARITY>(heap, 0, std::move(value));
+        }
+    }
+
+    // Сортируем саму кучу, как в heapsortDary: максимум -- в конец.
+    for (size_t end = k; end > 1; end--) {
+        T value = std::move(heap[end - 1]);
+        heap[end - 1] = std::move(heap[0]);
+        daryHeapSiftDown<HEAPSORT_ARITY>(heap.first(end - 1), 0, std::move(value));
+    }
+}
+
+// Выбор k-й порядковой статистики (k считается от нуля): после вызова arr[k]
+// -- тот элемент, который стоял бы на месте k в отсортированном массиве,
+// левее него -- не большие, правее -- не меньшие элементы.
+// Это быстрая сортировка, которая после каждого разбиения продолжает только в
+// ту часть, где лежит позиция k, поэтому в среднем работает за O(n). Опорный
+// элемент и разбиение те же, что в quicksortBlock (включая трёхпутевое
+// разбиение при повторах), а чтобы худший случай не вырождался в O(n^2), как
+// и в интроспективной сортировке, после 2 log n разбиений оставшаяся часть
+// досортировывается пирамидальной сортировкой (introselect) -- так худший
+// случай O(n log n).
+template<class T>
+requires requires (const T& a, const T& b) {
+   { a < b } -> std::convertible_to<bool>;
+   { a > b } -> std::convertible_to<bool>;
+}
+void nthElement(std::span<T> arr, size_t k) {
+    if (k >= arr.size()) {
+        throw std::invalid_argument("nthElement: k is out of range");
+    }
+
+    size_t depthLimit = 2 * (std::bit_width(arr.size()) - 1);
+    while (arr.size() > quicksortSmallThreshold<T>()) {
+        if (depthLimit == 0) {
+            heapsort(arr);
+            return;
+        }
+        depthLimit--;
+
+        PartitionRange equal;
+        if (choosePivot(arr)) {
+            equal = partitionThreeWay(arr);
+        } else {
+            size_t pivotIdx = partitionBlock(arr);
+            equal = {pivotIdx, pivotIdx + 1};
+        }
+
+        if (k < equal.begin) {
+            arr = arr.first(equal.begin);
+        } else if (k >= equal.end) {
+            k -= equal.end;
+            arr = arr.subspan(equal.end);
+        } else {
+            // k попало в часть из равных опорному -- они уже на местах.
+            return;
+        }
+    }
+
+    smallSort(arr);
+}